@@ -1,151 +1,136 @@
 #include <string.h>
 
 #include <esp_log.h>
-
-#include "bm1397.h"
-#include "bm1366.h"
-#include "bm1368.h"
-#include "bm1370.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "asic.h"
+#include "asic_driver.h"
 #include "device_config.h"
 #include "frequency_transition_bmXX.h"
+#include "nvs_config.h"
 
 static const double NONCE_SPACE = 4294967296.0; //  2^32
 
 static const char *TAG = "asic";
 
+static const asic_driver * const DRIVERS[] = {
+    &BM1397_DRIVER,
+    &BM1366_DRIVER,
+    &BM1368_DRIVER,
+    &BM1370_DRIVER,
+};
+
+// Resolved once in ASIC_init, so the hot path does not branch on the chip model
+static const asic_driver * driver;
+
+static nonce_range_plan nonce_plan;
+
 uint8_t ASIC_init(GlobalState * GLOBAL_STATE)
 {
     ESP_LOGI(TAG, "Initializing %dx %s", GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.name);
 
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            return BM1397_init(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value, GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.difficulty);
-        case BM1366:
-            return BM1366_init(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value, GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.difficulty);
-        case BM1368:
-            return BM1368_init(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value, GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.difficulty);
-        case BM1370:
-            return BM1370_init(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value, GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.difficulty);
+    const asic_driver * resolved = NULL;
+    for (int i = 0; i < sizeof(DRIVERS) / sizeof(DRIVERS[0]); i++) {
+        if (DRIVERS[i]->id == GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
+            resolved = DRIVERS[i];
+            break;
+        }
     }
-    return ESP_OK;
+    if (resolved == NULL) {
+        ESP_LOGE(TAG, "No driver for %s", GLOBAL_STATE->DEVICE_CONFIG.family.asic.name);
+        return 0;
+    }
+    driver = resolved;
+
+    nonce_range_plan * plan = NULL;
+    if (driver->hash_counting != 0) {
+        nonce_range_plan_init(&nonce_plan, nvs_config_get_u16(NVS_CONFIG_NONCE_RANGE_MODE), driver->hash_counting,
+                              GLOBAL_STATE->DEVICE_CONFIG.family.asic.small_core_count, GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value,
+                              ASIC_get_asic_job_frequency_ms(GLOBAL_STATE));
+        plan = &nonce_plan;
+    }
+
+    uint8_t chip_count = driver->init(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value, GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, GLOBAL_STATE->DEVICE_CONFIG.family.asic.difficulty, plan);
+    // From here on the result task reads the UART
+    frequency_transition_release_serial();
+    return chip_count;
 }
 
-task_result * ASIC_process_work(GlobalState * GLOBAL_STATE)
+const nonce_range_plan * ASIC_get_nonce_range_plan(GlobalState * GLOBAL_STATE)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            return BM1397_process_work(GLOBAL_STATE);
-        case BM1366:
-            return BM1366_process_work(GLOBAL_STATE);
-        case BM1368:
-            return BM1368_process_work(GLOBAL_STATE);
-        case BM1370:
-            return BM1370_process_work(GLOBAL_STATE);
+    if (driver == NULL || driver->hash_counting == 0 || nonce_plan.chip_count == 0) {
+        return NULL;
     }
-    return NULL;
+    return &nonce_plan;
+}
+
+task_result * ASIC_process_work(GlobalState * GLOBAL_STATE)
+{
+    return driver->process_work(GLOBAL_STATE);
 }
 
 int ASIC_set_max_baud(GlobalState * GLOBAL_STATE)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            return BM1397_set_max_baud();
-        case BM1366:
-            return BM1366_set_max_baud();
-        case BM1368:
-            return BM1368_set_max_baud();
-        case BM1370:
-            return BM1370_set_max_baud();
+    if (driver == NULL) {
+        return 0;
     }
-    return 0;
+    return driver->set_max_baud();
 }
 
 void ASIC_send_work(GlobalState * GLOBAL_STATE, void * next_job)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            BM1397_send_work(GLOBAL_STATE, next_job);
-            break;
-        case BM1366:
-            BM1366_send_work(GLOBAL_STATE, next_job);
-            break;
-        case BM1368:
-            BM1368_send_work(GLOBAL_STATE, next_job);
-            break;
-        case BM1370:
-            BM1370_send_work(GLOBAL_STATE, next_job);
-            break;
-    }
+    driver->send_work(GLOBAL_STATE, next_job);
 }
 
 void ASIC_set_version_mask(GlobalState * GLOBAL_STATE, uint32_t mask)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            BM1397_set_version_mask(mask);
-            break;
-        case BM1366:
-            BM1366_set_version_mask(mask);
-            break;
-        case BM1368:
-            BM1368_set_version_mask(mask);
-            break;
-        case BM1370:
-            BM1370_set_version_mask(mask);
-            break;
+    if (driver == NULL) {
+        return;
     }
+    driver->set_version_mask(mask);
 }
 
 bool ASIC_set_frequency(GlobalState * GLOBAL_STATE, float frequency)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            do_frequency_transition(frequency, BM1397_send_hash_frequency);
-            return true;
-        case BM1366:
-            do_frequency_transition(frequency, BM1366_send_hash_frequency);
-            return true;
-        case BM1368:
-            do_frequency_transition(frequency, BM1368_send_hash_frequency);
-            return true;
-        case BM1370:
-            do_frequency_transition(frequency, BM1370_send_hash_frequency);
-            return true;
+    if (driver == NULL) {
+        return false;
+    }
+    do_frequency_transition(frequency, driver->send_hash_frequency);
+    return true;
+}
+
+bool ASIC_set_chip_frequency(GlobalState * GLOBAL_STATE, uint8_t asic_nr, float frequency)
+{
+    const nonce_range_plan * plan = ASIC_get_nonce_range_plan(GLOBAL_STATE);
+    if (plan == NULL || driver->send_chip_hash_frequency == NULL || asic_nr >= plan->chip_count) {
+        return false;
     }
-    return false;
+    do_chip_frequency_transition(asic_nr, plan->chip_address[asic_nr], frequency, driver->send_chip_hash_frequency);
+    return true;
 }
 
 double ASIC_get_asic_job_frequency_ms(GlobalState * GLOBAL_STATE)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            // no version-rolling so same Nonce Space is splitted between Small Cores
-            return (NONCE_SPACE / (double) (GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value * GLOBAL_STATE->DEVICE_CONFIG.family.asic.small_core_count * 1000)) / (double) GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
-        case BM1366:
-            return 2000 / GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
-        case BM1368:
-        case BM1370:
-            return 500 / GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+    if (driver == NULL) {
+        return 500;
     }
-    return 500;
+    if (driver->job_interval_ms == 0) {
+        // no version-rolling so same Nonce Space is splitted between Small Cores
+        return (NONCE_SPACE / (double) (GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value * GLOBAL_STATE->DEVICE_CONFIG.family.asic.small_core_count * 1000)) / (double) GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+    }
+    return driver->job_interval_ms / GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
 }
 
 void ASIC_read_registers(GlobalState * GLOBAL_STATE)
 {
-    switch (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id) {
-        case BM1397:
-            BM1397_read_registers();
-            break;
-        case BM1366:
-            BM1366_read_registers();
-            break;
-        case BM1368:
-            BM1368_read_registers();
-            break;
-        case BM1370:
-            BM1370_read_registers();
-            break;
+    if (driver == NULL) {
+        return;
+    }
+    for (int reg = 0; reg < driver->register_map_size; reg++) {
+        if (driver->register_map[reg] != REGISTER_INVALID) {
+            send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_READ), (uint8_t[]){0x00, reg}, 2, false);
+            vTaskDelay(1 / portTICK_PERIOD_MS);
+        }
     }
 }
@@ -1,5 +1,6 @@
 #include "bm1366.h"
 
+#include "asic_driver.h"
 #include "crc.h"
 #include "global_state.h"
 #include "serial.h"
@@ -21,17 +22,6 @@
 #define BM1366_CHIP_ID 0x1366
 #define BM1366_CHIP_ID_RESPONSE_LENGTH 11
 
-#define TYPE_JOB 0x20
-#define TYPE_CMD 0x40
-
-#define GROUP_SINGLE 0x00
-#define GROUP_ALL 0x10
-
-#define CMD_SETADDRESS 0x00
-#define CMD_WRITE 0x01
-#define CMD_READ 0x02
-#define CMD_INACTIVE 0x03
-
 #define MISC_CONTROL 0x18
 
 static const register_type_t REGISTER_MAP[] = {
@@ -43,77 +33,9 @@ static const register_type_t REGISTER_MAP[] = {
     [0x8C] = REGISTER_TOTAL_COUNT
 };
 
-typedef struct __attribute__((__packed__))
-{
-    uint32_t nonce;                   // 2-5
-    uint8_t midstate_num;             // 6
-    uint8_t id;                       // 7
-    uint16_t version;                 // 8-9
-} bm1366_asic_result_job_t;
-
-typedef struct __attribute__((__packed__))
-{
-    uint32_t value;                   // 2-5
-    uint8_t asic_address;             // 6
-    uint8_t register_address;         // 7
-    uint16_t                  : 16;   // 8-9
-} bm1366_asic_result_cmd_t;
-
-typedef struct __attribute__((__packed__))
-{
-    uint16_t preamble;                // 0-1
-    union {
-        bm1366_asic_result_job_t job; // 2-9
-        bm1366_asic_result_cmd_t cmd; // 2-9
-    };
-    uint8_t crc             : 5;      // 10:0-5
-    uint8_t                 : 2;      // 10:6-7
-    uint8_t is_job_response : 1;      // 10:8
-} bm1366_asic_result_t;
-
 static const char * TAG = "bm1366";
 
-static task_result result;
-
-static int address_interval;
-
-/// @brief
-/// @param ftdi
-/// @param header
-/// @param data
-/// @param len
-static void _send_BM1366(uint8_t header, uint8_t * data, uint8_t data_len, bool debug)
-{
-    packet_type_t packet_type = (header & TYPE_JOB) ? JOB_PACKET : CMD_PACKET;
-    uint8_t total_length = (packet_type == JOB_PACKET) ? (data_len + 6) : (data_len + 5);
-
-    uint8_t buf[total_length];
-
-    // add the preamble
-    buf[0] = 0x55;
-    buf[1] = 0xAA;
-
-    // add the header field
-    buf[2] = header;
-
-    // add the length field
-    buf[3] = (packet_type == JOB_PACKET) ? (data_len + 4) : (data_len + 3);
-
-    // add the data
-    memcpy(buf + 4, data, data_len);
-
-    // add the correct crc type
-    if (packet_type == JOB_PACKET) {
-        uint16_t crc16_total = crc16_false(buf + 2, data_len + 2);
-        buf[4 + data_len] = (crc16_total >> 8) & 0xFF;
-        buf[5 + data_len] = crc16_total & 0xFF;
-    } else {
-        buf[4 + data_len] = crc5(buf + 2, data_len + 2);
-    }
-
-    // send serial data
-    SERIAL_send(buf, total_length, debug);
-}
+static nonce_range_plan * nonce_plan;
 
 static void _send_simple(uint8_t * data, uint8_t total_length)
 {
@@ -122,48 +44,46 @@ static void _send_simple(uint8_t * data, uint8_t total_length)
     SERIAL_send(buf, total_length, BM1366_SERIALTX_DEBUG);
 }
 
-static void _send_chain_inactive(void)
-{
-    unsigned char read_address[2] = {0x00, 0x00};
-    // send serial data
-    _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_INACTIVE), read_address, 2, BM1366_SERIALTX_DEBUG);
-}
-
-static void _set_chip_address(uint8_t chipAddr)
-{
-    ESP_LOGI(TAG, "Set chip address: 0x%02x", chipAddr);
-
-    unsigned char read_address[2] = {chipAddr, 0x00};
-    // send serial data
-    _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_SETADDRESS), read_address, 2, BM1366_SERIALTX_DEBUG);
-}
-
 void BM1366_set_version_mask(uint32_t version_mask) 
 {
     int versions_to_roll = version_mask >> 13;
     uint8_t version_byte0 = (versions_to_roll >> 8);
     uint8_t version_byte1 = (versions_to_roll & 0xFF); 
     uint8_t version_cmd[] = {0x00, 0xA4, 0x90, 0x00, version_byte0, version_byte1};
-    _send_BM1366(TYPE_CMD | GROUP_ALL | CMD_WRITE, version_cmd, 6, BM1366_SERIALTX_DEBUG);
+    send_asic_frame(TYPE_CMD | GROUP_ALL | CMD_WRITE, version_cmd, 6, BM1366_SERIALTX_DEBUG);
 }
 
-void BM1366_send_hash_frequency(float target_freq)
+static float send_pll(uint8_t group, uint8_t address, float target_freq)
 {
     uint8_t fb_divider, refdiv, postdiv1, postdiv2;
-    float new_freq;
-    
-    pll_get_parameters(target_freq, 144, 235, &fb_divider, &refdiv, &postdiv1, &postdiv2, &new_freq);
-    
+    float frequency;
+
+    pll_get_parameters(target_freq, 144, 235, &fb_divider, &refdiv, &postdiv1, &postdiv2, &frequency);
+
     uint8_t vdo_scale = (fb_divider * FREQ_MULT / refdiv >= 2400) ? 0x50 : 0x40;
     uint8_t postdiv = (((postdiv1 - 1) & 0xf) << 4) | ((postdiv2 - 1) & 0xf);
-    uint8_t freqbuf[6] = {0x00, 0x08, vdo_scale, fb_divider, refdiv, postdiv};
+    uint8_t freqbuf[6] = {address, 0x08, vdo_scale, fb_divider, refdiv, postdiv};
+
+    send_asic_frame(TYPE_CMD | group | CMD_WRITE, freqbuf, sizeof(freqbuf), BM1366_SERIALTX_DEBUG);
 
-    _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_WRITE), freqbuf, 6, BM1366_SERIALTX_DEBUG);
+    return frequency;
+}
+
+void BM1366_send_hash_frequency(float target_freq)
+{
+    float frequency = send_pll(GROUP_ALL, 0x00, target_freq);
 
-    ESP_LOGI(TAG, "Setting Frequency to %g MHz (%g)", target_freq, new_freq);
+    ESP_LOGI(TAG, "Setting Frequency to %g MHz (%g)", target_freq, frequency);
 }
 
-uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
+void BM1366_send_chip_hash_frequency(uint8_t address, float target_freq)
+{
+    float frequency = send_pll(GROUP_SINGLE, address, target_freq);
+
+    ESP_LOGI(TAG, "Setting Frequency of chip 0x%02X to %g MHz (%g)", address, target_freq, frequency);
+}
+
+uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty, nonce_range_plan * plan)
 {
     // set version mask
     for (int i = 0; i < 3; i++) {
@@ -174,7 +94,7 @@ uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
     unsigned char init3[7] = {0x55, 0xAA, 0x52, 0x05, 0x00, 0x00, 0x0A};
     _send_simple(init3, 7);
 
-    int chip_counter = count_asic_chips(asic_count, BM1366_CHIP_ID, BM1366_CHIP_ID_RESPONSE_LENGTH);
+    int chip_counter = count_asic_chips(asic_count, BM1366_DRIVER.chip_id, BM1366_DRIVER.chip_id_response_length);
 
     if (chip_counter == 0) {
         return 0;
@@ -187,13 +107,14 @@ uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
     _send_simple(init5, 11);
 
     //{0x55, 0xAA, 0x53, 0x05, 0x00, 0x00, 0x03};
-    _send_chain_inactive();
+    send_chain_inactive(BM1366_SERIALTX_DEBUG);
 
-    // split the chip address space evenly
-    address_interval = 256 / chip_counter;
-    for (uint8_t i = 0; i < chip_counter; i++) {
+    // split the chip address space evenly, BM1366 chains keep the stock layout
+    nonce_plan = plan;
+    nonce_range_plan_interval(nonce_plan, chip_counter);
+    for (uint8_t i = 0; i < nonce_plan->chip_count; i++) {
         //{ 0x55, 0xAA, 0x40, 0x05, 0x00, 0x00, 0x1C };
-        _set_chip_address(i * address_interval);
+        set_chip_address(nonce_plan->chip_address[i], BM1366_SERIALTX_DEBUG);
     }
 
     unsigned char init135[11] = {0x55, 0xAA, 0x51, 0x09, 0x00, 0x3C, 0x80, 0x00, 0x85, 0x40, 0x0C};
@@ -205,7 +126,7 @@ uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
     //set difficulty mask
     uint8_t difficulty_mask[6];
     get_difficulty_mask(difficulty, difficulty_mask);
-    _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_WRITE), difficulty_mask, 6, BM1366_SERIALTX_DEBUG);    
+    send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_WRITE), difficulty_mask, 6, BM1366_SERIALTX_DEBUG);    
 
     unsigned char init138[11] = {0x55, 0xAA, 0x51, 0x09, 0x00, 0x54, 0x00, 0x00, 0x00, 0x03, 0x1D};
     _send_simple(init138, 11);
@@ -220,28 +141,31 @@ uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
     // unsigned char init173[11] = {0x55, 0xAA, 0x51, 0x09, 0x00, 0x28, 0x11, 0x30, 0x02, 0x00, 0x03};
     // _send_simple(init173, 11);
 
-    for (uint8_t i = 0; i < chip_counter; i++) {
-        unsigned char set_a8_register[6] = {i * address_interval, 0xA8, 0x00, 0x07, 0x01, 0xF0};
-        _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_a8_register, 6, BM1366_SERIALTX_DEBUG);
-        unsigned char set_18_register[6] = {i * address_interval, 0x18, 0xF0, 0x00, 0xC1, 0x00};
-        _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_18_register, 6, BM1366_SERIALTX_DEBUG);
-        unsigned char set_3c_register_first[6] = {i * address_interval, 0x3C, 0x80, 0x00, 0x85, 0x40};
-        _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_first, 6, BM1366_SERIALTX_DEBUG);
-        unsigned char set_3c_register_second[6] = {i * address_interval, 0x3C, 0x80, 0x00, 0x80, 0x20};
-        _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_second, 6, BM1366_SERIALTX_DEBUG);
-        unsigned char set_3c_register_third[6] = {i * address_interval, 0x3C, 0x80, 0x00, 0x82, 0xAA};
-        _send_BM1366((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_third, 6, BM1366_SERIALTX_DEBUG);
+    for (uint8_t i = 0; i < nonce_plan->chip_count; i++) {
+        unsigned char set_a8_register[6] = {nonce_plan->chip_address[i], 0xA8, 0x00, 0x07, 0x01, 0xF0};
+        send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_a8_register, 6, BM1366_SERIALTX_DEBUG);
+        unsigned char set_18_register[6] = {nonce_plan->chip_address[i], 0x18, 0xF0, 0x00, 0xC1, 0x00};
+        send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_18_register, 6, BM1366_SERIALTX_DEBUG);
+        unsigned char set_3c_register_first[6] = {nonce_plan->chip_address[i], 0x3C, 0x80, 0x00, 0x85, 0x40};
+        send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_first, 6, BM1366_SERIALTX_DEBUG);
+        unsigned char set_3c_register_second[6] = {nonce_plan->chip_address[i], 0x3C, 0x80, 0x00, 0x80, 0x20};
+        send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_second, 6, BM1366_SERIALTX_DEBUG);
+        unsigned char set_3c_register_third[6] = {nonce_plan->chip_address[i], 0x3C, 0x80, 0x00, 0x82, 0xAA};
+        send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_WRITE), set_3c_register_third, 6, BM1366_SERIALTX_DEBUG);
     }
 
+    frequency_transition_init(chip_counter, nonce_plan);
     do_frequency_transition(frequency, BM1366_send_hash_frequency);
 
     //register 10 is still a bit of a mystery. discussion: https://github.com/bitaxeorg/ESP-Miner/pull/167
 
-    // unsigned char set_10_hash_counting[6] = {0x00, 0x10, 0x00, 0x00, 0x11, 0x5A}; //S19k Pro Default
-    // unsigned char set_10_hash_counting[6] = {0x00, 0x10, 0x00, 0x00, 0x14, 0x46}; //S19XP-Luxos Default
-    unsigned char set_10_hash_counting[6] = {0x00, 0x10, 0x00, 0x00, 0x15, 0x1C}; //S19XP-Stock Default
-    // unsigned char set_10_hash_counting[6] = {0x00, 0x10, 0x00, 0x0F, 0x00, 0x00}; //supposedly the "full" 32bit nonce range
-    _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_WRITE), set_10_hash_counting, 6, BM1366_SERIALTX_DEBUG);
+    // 0x0000115A S19k Pro Default
+    // 0x00001446 S19XP-Luxos Default
+    // 0x0000151C S19XP-Stock Default (BM1366_HASH_COUNTING)
+    // 0x000F0000 supposedly the "full" 32bit nonce range
+    uint32_t hash_counting = nonce_plan->hash_counting;
+    unsigned char set_10_hash_counting[6] = {0x00, 0x10, hash_counting >> 24, hash_counting >> 16, hash_counting >> 8, hash_counting};
+    send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_WRITE), set_10_hash_counting, 6, BM1366_SERIALTX_DEBUG);
 
     unsigned char init795[11] = {0x55, 0xAA, 0x51, 0x09, 0x00, 0xA4, 0x90, 0x00, 0xFF, 0xFF, 0x1C};
     _send_simple(init795, 11);
@@ -254,7 +178,7 @@ uint8_t BM1366_init(float frequency, uint16_t asic_count, uint16_t difficulty)
 
 //     unsigned char read_address[2] = {0x00, 0x00};
 //     // send serial data
-//     _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_READ), read_address, 2, BM1366_SERIALTX_DEBUG);
+//     send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_READ), read_address, 2, BM1366_SERIALTX_DEBUG);
 // }
 
 // Baud formula = 25M/((denominator+1)*8)
@@ -263,7 +187,7 @@ int BM1366_set_default_baud(void)
 {
     // default divider of 26 (11010) for 115,749
     unsigned char baudrate[9] = {0x00, MISC_CONTROL, 0x00, 0x00, 0b01111010, 0b00110001}; // baudrate - misc_control
-    _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_WRITE), baudrate, 6, BM1366_SERIALTX_DEBUG);
+    send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_WRITE), baudrate, 6, BM1366_SERIALTX_DEBUG);
     return 115749;
 }
 
@@ -308,63 +232,34 @@ void BM1366_send_work(void * pvParameters, bm_job * next_bm_job)
     ESP_LOGI(TAG, "Send Job: %02X", job.job_id);
     #endif
 
-    _send_BM1366((TYPE_JOB | GROUP_SINGLE | CMD_WRITE), (uint8_t *)&job, sizeof(BM1366_job), BM1366_DEBUG_WORK);
+    send_asic_frame((TYPE_JOB | GROUP_SINGLE | CMD_WRITE), (uint8_t *)&job, sizeof(BM1366_job), BM1366_DEBUG_WORK);
 }
 
 task_result * BM1366_process_work(void * pvParameters)
 {
-    bm1366_asic_result_t asic_result = {0};
-
-    memset(&result, 0, sizeof(task_result));
-
-    if (receive_work((uint8_t *)&asic_result, sizeof(asic_result)) == ESP_FAIL) {
-        return NULL;
-    }
-
-    if (!asic_result.is_job_response) {
-        result.register_type = REGISTER_MAP[asic_result.cmd.register_address];
-        if (result.register_type == REGISTER_INVALID) {
-            ESP_LOGW(TAG, "Unknown register read: %02x", asic_result.cmd.register_address);
-            return NULL;
-        }
-        result.asic_nr = asic_result.cmd.asic_address / address_interval;
-        result.value = ntohl(asic_result.cmd.value);
-        
-        return &result;
-    }
-
-    uint8_t job_id = asic_result.job.id & 0xf8;
-    uint32_t nonce_h = ntohl(asic_result.job.nonce);
-    uint8_t asic_nr = (uint8_t)((nonce_h >> 17) & 0xff) / address_interval; // Asic address is encoded in the next 8 bits
-    uint8_t core_id = (uint8_t)((nonce_h >> 25) & 0x7f); // BM1366 has 112 cores, so it should be coded on 7 bits
-    uint8_t small_core_id = asic_result.job.id & 0x07; // BM1366 has 8 small cores, so it should be coded on 3 bits
-    uint32_t version_bits = (ntohs(asic_result.job.version) << 13); // shift the 16 bit value left 13
-    ESP_LOGI(TAG, "Job ID: %02X, Asic nr: %d, Core: %d/%d, Ver: %08" PRIX32, job_id, asic_nr, core_id, small_core_id, version_bits);
-
-    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
-
-    if (GLOBAL_STATE->valid_jobs[job_id] == 0) {
-        ESP_LOGW(TAG, "Invalid job nonce found, 0x%02X", job_id);
-        return NULL;
-    }
-
-    uint32_t rolled_version = GLOBAL_STATE->ASIC_TASK_MODULE.active_jobs[job_id]->version | version_bits;
-
-    result.job_id = job_id;
-    result.nonce = asic_result.job.nonce;
-    result.rolled_version = rolled_version;
-    result.asic_nr = asic_nr;
-
-    return &result;
+    return process_version_rolling_work(&BM1366_DRIVER, nonce_plan, pvParameters);
 }
 
-void BM1366_read_registers(void)
-{
-    int size = sizeof(REGISTER_MAP) / sizeof(REGISTER_MAP[0]);
-    for (int reg = 0; reg < size; reg++) {
-        if (REGISTER_MAP[reg] != REGISTER_INVALID) {
-            _send_BM1366((TYPE_CMD | GROUP_ALL | CMD_READ), (uint8_t[]){0x00, reg}, 2, BM1366_SERIALTX_DEBUG);
-            vTaskDelay(1 / portTICK_PERIOD_MS);
-        }
-    }
-}
+const asic_driver BM1366_DRIVER = {
+    .id = BM1366,
+    .name = "BM1366",
+    .chip_id = BM1366_CHIP_ID,
+    .chip_id_response_length = BM1366_CHIP_ID_RESPONSE_LENGTH,
+    .register_map = REGISTER_MAP,
+    .register_map_size = sizeof(REGISTER_MAP) / sizeof(REGISTER_MAP[0]),
+    .pll_register = 0x08,
+    .job_id_mask = 0xf8,
+    .job_id_shift = 0,
+    .small_core_mask = 0x07,
+    .core_id_shift = 25,
+    .core_id_mask = 0x7f,
+    .hash_counting = BM1366_HASH_COUNTING,
+    .job_interval_ms = 2000,
+    .init = BM1366_init,
+    .process_work = BM1366_process_work,
+    .set_max_baud = BM1366_set_max_baud,
+    .send_work = BM1366_send_work,
+    .set_version_mask = BM1366_set_version_mask,
+    .send_hash_frequency = BM1366_send_hash_frequency,
+    .send_chip_hash_frequency = BM1366_send_chip_hash_frequency,
+};
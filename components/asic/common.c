@@ -1,7 +1,12 @@
 #include <string.h>
 #include <stdbool.h>
 
+#include <arpa/inet.h>
+#include <inttypes.h>
+
 #include "common.h"
+#include "asic_driver.h"
+#include "global_state.h"
 #include "serial.h"
 #include "esp_log.h"
 #include "crc.h"
@@ -10,6 +15,8 @@
 
 static const char * TAG = "common";
 
+static task_result result;
+
 unsigned char _reverse_bits(unsigned char num)
 {
     unsigned char reversed = 0;
@@ -88,9 +95,9 @@ int count_asic_chips(uint16_t asic_count, uint16_t chip_id, int chip_id_response
     return chip_counter;
 }
 
-esp_err_t receive_work(uint8_t * buffer, int buffer_size)
+static esp_err_t receive_frame(uint8_t * buffer, int buffer_size, uint16_t timeout_ms)
 {
-    int received = SERIAL_rx(buffer, buffer_size, 10000);
+    int received = SERIAL_rx(buffer, buffer_size, timeout_ms);
 
     if (received < 0) {
         ESP_LOGE(TAG, "UART error in serial RX");
@@ -127,6 +134,25 @@ esp_err_t receive_work(uint8_t * buffer, int buffer_size)
     return ESP_OK;
 }
 
+esp_err_t receive_work(uint8_t * buffer, int buffer_size)
+{
+    return receive_frame(buffer, buffer_size, 10000);
+}
+
+esp_err_t receive_register_read(uint16_t timeout_ms, uint8_t * asic_address, uint8_t * register_address, uint32_t * value)
+{
+    asic_result_t asic_result = {0};
+
+    if (receive_frame((uint8_t *)&asic_result, sizeof(asic_result), timeout_ms) != ESP_OK || asic_result.is_job_response) {
+        return ESP_FAIL;
+    }
+
+    *asic_address = asic_result.cmd.asic_address;
+    *register_address = asic_result.cmd.register_address;
+    *value = ntohl(asic_result.cmd.value);
+    return ESP_OK;
+}
+
 void get_difficulty_mask(uint16_t difficulty, uint8_t *job_difficulty_mask)
 {
     // The mask must be a power of 2 so there are no holes
@@ -145,3 +171,103 @@ void get_difficulty_mask(uint16_t difficulty, uint8_t *job_difficulty_mask)
     job_difficulty_mask[4] = _reverse_bits((difficulty >>  8) & 0xFF);
     job_difficulty_mask[5] = _reverse_bits( difficulty        & 0xFF);
 }
+
+void send_asic_frame(uint8_t header, const uint8_t * data, uint8_t data_len, bool debug)
+{
+    packet_type_t packet_type = (header & TYPE_JOB) ? JOB_PACKET : CMD_PACKET;
+    const uint8_t total_length = (packet_type == JOB_PACKET) ? (data_len + 6) : (data_len + 5);
+
+    uint8_t buf[total_length];
+
+    // add the preamble
+    buf[0] = 0x55;
+    buf[1] = 0xAA;
+
+    // add the header field
+    buf[2] = header;
+
+    // add the length field
+    buf[3] = (packet_type == JOB_PACKET) ? (data_len + 4) : (data_len + 3);
+
+    // add the data
+    memcpy(buf + 4, data, data_len);
+
+    // add the correct crc type
+    if (packet_type == JOB_PACKET) {
+        uint16_t crc16_total = crc16_false(buf + 2, data_len + 2);
+        buf[4 + data_len] = (crc16_total >> 8) & 0xFF;
+        buf[5 + data_len] = crc16_total & 0xFF;
+    } else {
+        buf[4 + data_len] = crc5(buf + 2, data_len + 2);
+    }
+
+    // send serial data
+    if (SERIAL_send(buf, total_length, debug) == 0) {
+        ESP_LOGE(TAG, "Failed to send data to the ASIC");
+    }
+}
+
+void send_chain_inactive(bool debug)
+{
+    send_asic_frame((TYPE_CMD | GROUP_ALL | CMD_INACTIVE), (uint8_t[]){0x00, 0x00}, 2, debug);
+}
+
+void set_chip_address(uint8_t chip_address, bool debug)
+{
+    send_asic_frame((TYPE_CMD | GROUP_SINGLE | CMD_SETADDRESS), (uint8_t[]){chip_address, 0x00}, 2, debug);
+}
+
+task_result * process_version_rolling_work(const asic_driver * driver, const nonce_range_plan * plan, void * pvParameters)
+{
+    asic_result_t asic_result = {0};
+
+    memset(&result, 0, sizeof(task_result));
+
+    if (receive_work((uint8_t *)&asic_result, sizeof(asic_result)) == ESP_FAIL) {
+        return NULL;
+    }
+
+    if (!asic_result.is_job_response) {
+        if (driver->pll_register != 0 && asic_result.cmd.register_address == driver->pll_register) {
+            result.register_type = REGISTER_PLL_PARAMETER;
+        } else if (asic_result.cmd.register_address < driver->register_map_size) {
+            result.register_type = driver->register_map[asic_result.cmd.register_address];
+        } else {
+            result.register_type = REGISTER_INVALID;
+        }
+        if (result.register_type == REGISTER_INVALID) {
+            ESP_LOGW(driver->name, "Unknown register read: %02x", asic_result.cmd.register_address);
+            return NULL;
+        }
+        result.asic_nr = nonce_range_chip_for_address(plan, asic_result.cmd.asic_address);
+        result.value = ntohl(asic_result.cmd.value);
+
+        return &result;
+    }
+
+    uint8_t job_id = (asic_result.job.id & driver->job_id_mask) >> driver->job_id_shift;
+    uint32_t nonce_h = ntohl(asic_result.job.nonce);
+    uint8_t asic_nr = nonce_range_chip_for_nonce(plan, nonce_h); // Asic address is encoded in the next 8 bits
+    uint8_t core_id = (uint8_t)((nonce_h >> driver->core_id_shift) & driver->core_id_mask);
+    uint8_t small_core_id = asic_result.job.id & driver->small_core_mask;
+    uint32_t version_bits = (ntohs(asic_result.job.version) << 13); // shift the 16 bit value left 13
+    ESP_LOGD(driver->name, "Job ID: %02X, Asic nr: %d, Core: %d/%d, Ver: %08" PRIX32, job_id, asic_nr, core_id, small_core_id, version_bits);
+
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+
+    if (GLOBAL_STATE->valid_jobs[job_id] == 0) {
+        ESP_LOGW(driver->name, "Invalid job nonce found, 0x%02X", job_id);
+        return NULL;
+    }
+
+    uint32_t rolled_version = GLOBAL_STATE->ASIC_TASK_MODULE.active_jobs[job_id]->version | version_bits;
+
+    result.job_id = job_id;
+    result.nonce = asic_result.job.nonce;
+    result.rolled_version = rolled_version;
+    result.asic_nr = asic_nr;
+    result.core_id = core_id;
+    result.small_core_id = small_core_id;
+
+    return &result;
+}
@@ -0,0 +1,55 @@
+#include <math.h>
+#include "core_nonces.h"
+
+void core_nonces_decay(uint16_t * nonces, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        nonces[i] >>= 1;
+    }
+}
+
+void core_nonces_add(uint16_t * chip_nonces, uint8_t core_id, uint8_t small_core_id)
+{
+    uint16_t * counter = &chip_nonces[core_id * CORE_NONCES_SMALL_CORES + small_core_id];
+    if (*counter == UINT16_MAX) {
+        core_nonces_decay(chip_nonces, CORE_NONCES_CHIP_SIZE);
+    }
+    (*counter)++;
+}
+
+uint32_t core_nonces_core_total(const uint16_t * chip_nonces, uint8_t core_id)
+{
+    const uint16_t * small_cores = &chip_nonces[core_id * CORE_NONCES_SMALL_CORES];
+
+    uint32_t total = 0;
+    for (int small_core_id = 0; small_core_id < CORE_NONCES_SMALL_CORES; small_core_id++) {
+        total += small_cores[small_core_id];
+    }
+    return total;
+}
+
+int core_nonces_low_cores(const uint16_t * chip_nonces, int core_count, uint8_t * low_cores, int max_low_cores)
+{
+    if (core_count > CORE_NONCES_CORES) core_count = CORE_NONCES_CORES;
+    if (core_count <= 0) return 0;
+
+    uint32_t core_totals[CORE_NONCES_CORES];
+    uint32_t chip_total = 0;
+    for (int core_id = 0; core_id < core_count; core_id++) {
+        core_totals[core_id] = core_nonces_core_total(chip_nonces, core_id);
+        chip_total += core_totals[core_id];
+    }
+
+    // Nonces per core are Poisson distributed around the chip average
+    float expected = (float) chip_total / core_count;
+    if (expected < CORE_NONCES_MIN_EXPECTED) return 0;
+    float threshold = expected - CORE_NONCES_LOW_SIGMA * sqrtf(expected);
+
+    int found = 0;
+    for (int core_id = 0; core_id < core_count && found < max_low_cores; core_id++) {
+        if (core_totals[core_id] < threshold) {
+            low_cores[found++] = core_id;
+        }
+    }
+    return found;
+}
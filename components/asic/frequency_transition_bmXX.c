@@ -1,4 +1,5 @@
 #include "frequency_transition_bmXX.h"
+#include "common.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -6,46 +7,199 @@
 
 #define EPSILON 0.0001f
 #define STEP_SIZE 6.25 // MHz step size
+#define RESET_FREQUENCY 50 // MHz the chips run at after a reset
+
+// A verified step up adds about this share of the current frequency, so the load
+// grows by the same fraction on every step; shedding load is easier on the regulator
+#define RAMP_UP_SHARE 0.1f
+#define RAMP_DOWN_SHARE 0.25f
+#define RAMP_MAX_STEPS 8 // grid steps, 50 MHz
+
+// Upper bound for the PLL to report a lock, and the fixed delay per step without read-back
+#define PLL_LOCK_TIMEOUT_MS 100
+
+#define PLL0_PARAMETER 0x08
+#define PLL_LOCKED (1u << 31)
 
 static const char * TAG = "frequency_transition";
 
-static float current_frequency = 50; // Mhz
+static uint8_t chip_count = 1;
+static float current_frequency[NONCE_RANGE_MAX_CHIPS] = {RESET_FREQUENCY}; // Mhz
+static const nonce_range_plan * nonce_plan;
 
-void do_frequency_transition(float target_frequency, set_hash_frequency_fn set_frequency_fn)
+// Steps are only verified while the chips answer the PLL read-back
+static bool read_back;
+// The drivers initialize the chips before the result task reads the UART
+static bool direct_read;
+
+// Chips that answered / reported a locked PLL since the last read-back was sent
+static volatile uint32_t answered_chips;
+static volatile uint32_t locked_chips;
+// Set while a read-back sent by the ramp is outstanding, other replies are ignored
+static volatile bool read_pending;
+
+void frequency_transition_init(uint8_t count, const nonce_range_plan * plan)
 {
-    if (fabs(current_frequency - target_frequency) < EPSILON) {
-        return;
+    chip_count = count > NONCE_RANGE_MAX_CHIPS ? NONCE_RANGE_MAX_CHIPS : count;
+    for (int i = 0; i < chip_count; i++) {
+        current_frequency[i] = RESET_FREQUENCY;
     }
+    nonce_plan = plan;
+    read_back = plan != NULL;
+    direct_read = true;
+}
 
-    if (fabs(target_frequency - current_frequency) < STEP_SIZE) {
-        current_frequency = target_frequency;
-        set_frequency_fn(current_frequency);
+void frequency_transition_release_serial(void)
+{
+    direct_read = false;
+}
+
+void frequency_transition_pll_read(uint8_t asic_nr, uint32_t value)
+{
+    if (!read_pending || asic_nr >= chip_count) {
         return;
     }
+    answered_chips |= 1u << asic_nr;
+    if (value & PLL_LOCKED) {
+        locked_chips |= 1u << asic_nr;
+    }
+}
+
+// Reads back register 0x08, true once every chip in mask reports a locked PLL
+static bool wait_for_lock(uint8_t group, uint8_t address, uint32_t mask)
+{
+    answered_chips = 0;
+    locked_chips = 0;
+    read_pending = true;
+    send_asic_frame((TYPE_CMD | group | CMD_READ), (uint8_t[]){address, PLL0_PARAMETER}, 2, false);
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(PLL_LOCK_TIMEOUT_MS);
+    while ((locked_chips & mask) != mask) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            read_pending = false;
+            return false;
+        }
+        if (direct_read) {
+            uint8_t asic_address, register_address;
+            uint32_t value;
+            if (receive_register_read((timeout - elapsed) * portTICK_PERIOD_MS, &asic_address, &register_address, &value) == ESP_OK &&
+                register_address == PLL0_PARAMETER) {
+                frequency_transition_pll_read(nonce_range_chip_for_address(nonce_plan, asic_address), value);
+            }
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    read_pending = false;
+    return true;
+}
 
-    ESP_LOGI(TAG, "Ramping up frequency from %g MHz to %g MHz", current_frequency, target_frequency);
+// Waits until the step took, true when the chips confirmed their PLL locked
+static bool settle(float frequency, uint8_t group, uint8_t address, uint32_t mask)
+{
+    if (!read_back) {
+        vTaskDelay(PLL_LOCK_TIMEOUT_MS / portTICK_PERIOD_MS);
+        return false;
+    }
 
-    int current_step = (target_frequency > current_frequency) ? (int)floor(current_frequency / STEP_SIZE) : (int)ceil(current_frequency / STEP_SIZE);
-    int target_step = (target_frequency > current_frequency) ? (int)floor(target_frequency / STEP_SIZE) : (int)ceil(target_frequency / STEP_SIZE);
+    if (wait_for_lock(group, address, mask)) {
+        return true;
+    }
+
+    if ((answered_chips & mask) == 0) {
+        read_back = false;
+        ESP_LOGW(TAG, "No PLL read-back, ramping in %g MHz steps", STEP_SIZE);
+    } else {
+        ESP_LOGW(TAG, "PLL of %d chip(s) not locked at %g MHz", __builtin_popcount(mask & ~locked_chips), frequency);
+    }
+    return false;
+}
 
-    if (current_step != target_step) {
-        int signum = (target_frequency > current_frequency) ? 1 : -1;
-        
-        while ((signum > 0 && current_step < target_step) ||
-               (signum < 0 && current_step > target_step)) {
-            current_step += signum;
+// Next frequency towards the target, on the 6.25 MHz grid. Steps only grow
+// after the previous one was verified.
+static float next_step(float frequency, float target_frequency, bool verified)
+{
+    int signum = (target_frequency > frequency) ? 1 : -1;
+
+    int steps = 1;
+    if (verified) {
+        float share = (signum > 0) ? RAMP_UP_SHARE : RAMP_DOWN_SHARE;
+        steps = fminf(fmaxf(floorf(frequency * share / STEP_SIZE), 1), RAMP_MAX_STEPS);
+    }
 
-            current_frequency = current_step * STEP_SIZE;
-            set_frequency_fn(current_frequency);
-            
-            vTaskDelay(100 / portTICK_PERIOD_MS);
+    float grid_step = (signum > 0) ? floorf(frequency / STEP_SIZE) : ceilf(frequency / STEP_SIZE);
+    float next = (grid_step + signum * steps) * STEP_SIZE;
+
+    return (signum > 0) ? fminf(next, target_frequency) : fmaxf(next, target_frequency);
+}
+
+// Steps from frequency to the target, either broadcast (set_chip_frequency_fn NULL)
+// or to the chip at address. Returns the number of steps.
+static int ramp(float frequency, float target_frequency, uint8_t group, uint8_t address, uint32_t mask,
+                set_hash_frequency_fn set_frequency_fn, set_chip_hash_frequency_fn set_chip_frequency_fn)
+{
+    int steps = 0;
+    bool verified = false; // the first step is small, nothing was read back yet
+
+    while (fabsf(frequency - target_frequency) > EPSILON) {
+        frequency = next_step(frequency, target_frequency, verified);
+        if (set_chip_frequency_fn != NULL) {
+            set_chip_frequency_fn(address, frequency);
+        } else {
+            set_frequency_fn(frequency);
+        }
+        steps++;
+
+        if (fabsf(frequency - target_frequency) > EPSILON) {
+            verified = settle(frequency, group, address, mask);
         }
     }
-    
-    if (fabs(current_frequency - target_frequency) > EPSILON) {
-        current_frequency = target_frequency;
-        set_frequency_fn(current_frequency);
+
+    return steps;
+}
+
+void do_frequency_transition(float target_frequency, set_hash_frequency_fn set_frequency_fn)
+{
+    // Every step is broadcast, so start from the chip that is furthest away
+    float frequency = current_frequency[0];
+    for (int i = 1; i < chip_count; i++) {
+        if (fabsf(current_frequency[i] - target_frequency) > fabsf(frequency - target_frequency)) {
+            frequency = current_frequency[i];
+        }
     }
-    
-    ESP_LOGI(TAG, "Successfully transitioned to %g MHz", target_frequency);
+
+    if (fabsf(frequency - target_frequency) < EPSILON) {
+        return;
+    }
+
+    bool log = fabsf(target_frequency - frequency) >= STEP_SIZE;
+    if (log) {
+        ESP_LOGI(TAG, "Ramping %s frequency from %g MHz to %g MHz", (target_frequency > frequency) ? "up" : "down", frequency,
+                 target_frequency);
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    uint32_t mask = (chip_count >= 32) ? UINT32_MAX : (1u << chip_count) - 1;
+    int steps = ramp(frequency, target_frequency, GROUP_ALL, 0x00, mask, set_frequency_fn, NULL);
+
+    for (int i = 0; i < chip_count; i++) {
+        current_frequency[i] = target_frequency;
+    }
+
+    if (log) {
+        ESP_LOGI(TAG, "Successfully transitioned to %g MHz in %d steps, %lu ms", target_frequency, steps,
+                 (unsigned long) ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS));
+    }
+}
+
+void do_chip_frequency_transition(uint8_t asic_nr, uint8_t address, float target_frequency, set_chip_hash_frequency_fn set_frequency_fn)
+{
+    if (asic_nr >= chip_count) {
+        return;
+    }
+
+    ramp(current_frequency[asic_nr], target_frequency, GROUP_SINGLE, address, 1u << asic_nr, NULL, set_frequency_fn);
+    current_frequency[asic_nr] = target_frequency;
 }
@@ -4,6 +4,7 @@
 #include <esp_err.h>
 #include "global_state.h"
 #include "common.h"
+#include "nonce_range.h"
 
 uint8_t ASIC_init(GlobalState * GLOBAL_STATE);
 task_result * ASIC_process_work(GlobalState * GLOBAL_STATE);
@@ -11,7 +12,12 @@ int ASIC_set_max_baud(GlobalState * GLOBAL_STATE);
 void ASIC_send_work(GlobalState * GLOBAL_STATE, void * next_job);
 void ASIC_set_version_mask(GlobalState * GLOBAL_STATE, uint32_t mask);
 bool ASIC_set_frequency(GlobalState * GLOBAL_STATE, float target_frequency);
+// Sets the PLL of one chip without ramping, the next ASIC_set_frequency overrides it.
+// Returns false when the chips cannot be clocked individually.
+bool ASIC_set_chip_frequency(GlobalState * GLOBAL_STATE, uint8_t asic_nr, float frequency);
 double ASIC_get_asic_job_frequency_ms(GlobalState * GLOBAL_STATE);
 void ASIC_read_registers(GlobalState * GLOBAL_STATE);
+// Nonce range plan of the initialized chips, NULL when the ASIC does not use one
+const nonce_range_plan * ASIC_get_nonce_range_plan(GlobalState * GLOBAL_STATE);
 
 #endif // ASIC_H
@@ -0,0 +1,54 @@
+#ifndef ASIC_DRIVER_H_
+#define ASIC_DRIVER_H_
+
+#include "common.h"
+#include "device_config.h"
+#include "mining.h"
+#include "nonce_range.h"
+
+typedef struct
+{
+    Asic id;
+    const char * name;
+    // Chip id register value and the length of its reply, used to count the chips on the chain
+    uint16_t chip_id;
+    uint8_t chip_id_response_length;
+
+    // Register address -> counter polled by the hashrate monitor
+    const register_type_t * register_map;
+    uint16_t register_map_size;
+    // PLL0 parameter register, only read back by frequency ramps (0 when not supported)
+    uint8_t pll_register;
+
+    // Job result layout: job id and small core are packed in the id byte,
+    // the core id sits in the top bits of the nonce (masks are 0 when not reported)
+    uint8_t job_id_mask;
+    uint8_t job_id_shift;
+    uint8_t small_core_mask;
+    uint8_t core_id_shift;
+    uint8_t core_id_mask;
+
+    // Stock register 0x10 value, 0 when the chip does not use a nonce range plan
+    uint32_t hash_counting;
+    // Job interval of a single chip, 0 to derive it from the nonce space (no version rolling)
+    uint16_t job_interval_ms;
+
+    uint8_t (*init)(float frequency, uint16_t asic_count, uint16_t difficulty, nonce_range_plan * plan);
+    task_result * (*process_work)(void * GLOBAL_STATE);
+    int (*set_max_baud)(void);
+    void (*send_work)(void * GLOBAL_STATE, bm_job * next_bm_job);
+    void (*set_version_mask)(uint32_t version_mask);
+    void (*send_hash_frequency)(float frequency);
+    // Writes the PLL of a single chip, NULL when chips cannot be clocked individually
+    void (*send_chip_hash_frequency)(uint8_t address, float frequency);
+} asic_driver;
+
+extern const asic_driver BM1397_DRIVER;
+extern const asic_driver BM1366_DRIVER;
+extern const asic_driver BM1368_DRIVER;
+extern const asic_driver BM1370_DRIVER;
+
+// Receives and decodes one asic_result_t frame using the driver's layout
+task_result * process_version_rolling_work(const asic_driver * driver, const nonce_range_plan * plan, void * GLOBAL_STATE);
+
+#endif /* ASIC_DRIVER_H_ */
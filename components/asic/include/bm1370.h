@@ -3,12 +3,16 @@
 
 #include "common.h"
 #include "mining.h"
+#include "nonce_range.h"
 
 #define BM1370_SERIALTX_DEBUG false
 #define BM1370_SERIALRX_DEBUG false
 #define BM1370_DEBUG_WORK false //causes insane amount of debug output
 #define BM1370_DEBUG_JOBS false //causes insane amount of debug output
 
+// Register 0x10 value from the stock firmware
+#define BM1370_HASH_COUNTING 0x00001EB5
+
 typedef struct __attribute__((__packed__))
 {
     uint8_t job_id;
@@ -21,13 +25,13 @@ typedef struct __attribute__((__packed__))
     uint8_t version[4];
 } BM1370_job;
 
-uint8_t BM1370_init(float frequency, uint16_t asic_count, uint16_t difficulty);
+uint8_t BM1370_init(float frequency, uint16_t asic_count, uint16_t difficulty, nonce_range_plan * plan);
 void BM1370_send_work(void * GLOBAL_STATE, bm_job * next_bm_job);
 void BM1370_set_version_mask(uint32_t version_mask);
 int BM1370_set_max_baud(void);
 int BM1370_set_default_baud(void);
 void BM1370_send_hash_frequency(float frequency);
+void BM1370_send_chip_hash_frequency(uint8_t address, float frequency);
 task_result * BM1370_process_work(void * GLOBAL_STATE);
-void BM1370_read_registers(void);
 
 #endif /* BM1370_H_ */
@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "mining.h"
+#include "nonce_range.h"
 
 #define BM1397_SERIALTX_DEBUG false
 #define BM1397_SERIALRX_DEBUG false
@@ -23,13 +24,12 @@ typedef struct __attribute__((__packed__))
     uint8_t midstate3[32];
 } job_packet;
 
-uint8_t BM1397_init(float frequency, uint16_t asic_count, uint16_t difficulty);
+uint8_t BM1397_init(float frequency, uint16_t asic_count, uint16_t difficulty, nonce_range_plan * plan);
 void BM1397_send_work(void * GLOBAL_STATE, bm_job * next_bm_job);
 void BM1397_set_version_mask(uint32_t version_mask);
 int BM1397_set_max_baud(void);
 int BM1397_set_default_baud(void);
 void BM1397_send_hash_frequency(float frequency);
 task_result * BM1397_process_work(void * GLOBAL_STATE);
-void BM1397_read_registers(void);
 
 #endif /* BM1397_H_ */
@@ -5,6 +5,18 @@
 #include <stdbool.h>
 #include "esp_err.h"
 
+// Frame header fields shared by the BM13xx chips
+#define TYPE_JOB 0x20
+#define TYPE_CMD 0x40
+
+#define GROUP_SINGLE 0x00
+#define GROUP_ALL 0x10
+
+#define CMD_SETADDRESS 0x00
+#define CMD_WRITE 0x01
+#define CMD_READ 0x02
+#define CMD_INACTIVE 0x03
+
 typedef enum
 {
     REGISTER_INVALID = 0,
@@ -15,6 +27,7 @@ typedef enum
     REGISTER_DOMAIN_2_COUNT,
     REGISTER_DOMAIN_3_COUNT,
     REGISTER_ERROR_COUNT,    // error count register (all)
+    REGISTER_PLL_PARAMETER,  // PLL0 parameter register, bit 31 is the lock flag (BM1366,BM1368,BM1370)
 } register_type_t;
 
 typedef struct
@@ -23,18 +36,56 @@ typedef struct
     uint8_t job_id;
     uint32_t nonce;
     uint32_t rolled_version;
+    uint8_t core_id;
+    uint8_t small_core_id;
     // ---- register response
     register_type_t register_type;
     uint8_t asic_nr;
     uint32_t value;
 } task_result;
 
+// Response frame of the version rolling chips (BM1366, BM1368, BM1370)
+typedef struct __attribute__((__packed__))
+{
+    uint32_t nonce;                   // 2-5
+    uint8_t midstate_num;             // 6
+    uint8_t id;                       // 7
+    uint16_t version;                 // 8-9
+} asic_result_job_t;
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t value;                   // 2-5
+    uint8_t asic_address;             // 6
+    uint8_t register_address;         // 7
+    uint16_t                  : 16;   // 8-9
+} asic_result_cmd_t;
+
+typedef struct __attribute__((__packed__))
+{
+    uint16_t preamble;                // 0-1
+    union {
+        asic_result_job_t job;        // 2-9
+        asic_result_cmd_t cmd;        // 2-9
+    };
+    uint8_t crc             : 5;      // 10:0-5
+    uint8_t                 : 2;      // 10:6-7
+    uint8_t is_job_response : 1;      // 10:8
+} asic_result_t;
+
 
 unsigned char _reverse_bits(unsigned char num);
 int _largest_power_of_two(int num);
 
 int count_asic_chips(uint16_t asic_count, uint16_t chip_id, int chip_id_response_length);
 esp_err_t receive_work(uint8_t * buffer, int buffer_size);
+// Receives one register response of the version rolling chips, for when no result task reads the UART
+esp_err_t receive_register_read(uint16_t timeout_ms, uint8_t * asic_address, uint8_t * register_address, uint32_t * value);
 void get_difficulty_mask(uint16_t difficulty, uint8_t *job_difficulty_mask);
 
+// Frame codec: adds preamble, length and the crc5 (commands) or crc16 (jobs)
+void send_asic_frame(uint8_t header, const uint8_t * data, uint8_t data_len, bool debug);
+void send_chain_inactive(bool debug);
+void set_chip_address(uint8_t chip_address, bool debug);
+
 #endif /* COMMON_H_ */
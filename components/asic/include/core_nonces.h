@@ -0,0 +1,33 @@
+#ifndef CORE_NONCES_H_
+#define CORE_NONCES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Nonce histogram layout: 7 bit core id, up to 16 small cores per core
+#define CORE_NONCES_CORES 128
+#define CORE_NONCES_SMALL_CORES 16
+#define CORE_NONCES_CHIP_SIZE (CORE_NONCES_CORES * CORE_NONCES_SMALL_CORES)
+
+#define CORE_NONCES_LOW_SIGMA 4.0f     // standard deviations below the expected share to flag a core
+#define CORE_NONCES_MIN_EXPECTED 20.0f // nonces per core needed before cores are judged
+
+// Counters of one chip start at chip_nonces, CORE_NONCES_CHIP_SIZE of them
+// indexed [core][small core]
+
+// Halves count counters so old results fade out
+void core_nonces_decay(uint16_t * nonces, size_t count);
+
+// Counts a nonce, a saturated counter halves the whole chip first so the
+// shares of its cores stay comparable
+void core_nonces_add(uint16_t * chip_nonces, uint8_t core_id, uint8_t small_core_id);
+
+uint32_t core_nonces_core_total(const uint16_t * chip_nonces, uint8_t core_id);
+
+// Fills low_cores with the first of core_count cores whose total is more than
+// CORE_NONCES_LOW_SIGMA standard deviations below the chip average and returns
+// how many were found. None are judged before the average reaches
+// CORE_NONCES_MIN_EXPECTED.
+int core_nonces_low_cores(const uint16_t * chip_nonces, int core_count, uint8_t * low_cores, int max_low_cores);
+
+#endif /* CORE_NONCES_H_ */
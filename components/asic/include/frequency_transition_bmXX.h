@@ -2,29 +2,81 @@
 #define FREQUENCY_TRANSITION_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "nonce_range.h"
 
 extern const char *FREQUENCY_TRANSITION_TAG;
 
 /**
  * @brief Function pointer type for ASIC hash frequency setting functions
- * 
+ *
  * This type defines the signature for functions that set the hash frequency
  * for different ASIC types.
- * 
+ *
  * @param frequency The frequency to set in MHz
  */
 typedef void (*set_hash_frequency_fn)(float frequency);
 
+/**
+ * @brief Function pointer type for setting the hash frequency of a single chip
+ *
+ * @param address The chip address
+ * @param frequency The frequency to set in MHz
+ */
+typedef void (*set_chip_hash_frequency_fn)(uint8_t address, float frequency);
+
+/**
+ * @brief Start tracking freshly addressed chips at their reset frequency
+ *
+ * Called by the drivers once the chip addresses are set. With a nonce range
+ * plan every step of a ramp is verified by reading back the PLL lock bit of
+ * register 0x08; until frequency_transition_release_serial() the responses are
+ * read straight from the UART. Without a plan the ramp falls back to fixed delays.
+ *
+ * @param chip_count Number of chips on the chain
+ * @param plan Chip addresses, or NULL when the PLL cannot be read back
+ */
+void frequency_transition_init(uint8_t chip_count, const nonce_range_plan * plan);
+
+/**
+ * @brief Hand the UART over to the result task
+ *
+ * From here on the PLL read-back arrives through frequency_transition_pll_read().
+ */
+void frequency_transition_release_serial(void);
+
+/**
+ * @brief Record a PLL parameter register read of a chip
+ *
+ * @param asic_nr The chip that answered
+ * @param value The register value
+ */
+void frequency_transition_pll_read(uint8_t asic_nr, uint32_t value);
+
 /**
  * @brief Transition the ASIC frequency to a target value
- * 
- * This function gradually adjusts the ASIC frequency to reach the target value,
- * stepping up or down in increments to ensure stability.
- * 
+ *
+ * This function gradually adjusts the frequency of all chips to reach the target
+ * value. Steps grow with the frequency while every chip confirms its PLL locked
+ * after the previous one, and fall back to 6.25 MHz steps with a fixed delay
+ * when the PLL cannot be read back.
+ *
  * @param target_frequency The target frequency in MHz
  * @param set_frequency_fn Function pointer to the appropriate ASIC's set_hash_frequency function
- * @param asic_type The type of ASIC chip (for logging purposes only)
  */
 void do_frequency_transition(float target_frequency, set_hash_frequency_fn set_frequency_fn);
 
+/**
+ * @brief Transition the frequency of a single chip to a target value
+ *
+ * Same ramp as do_frequency_transition(), starting from the frequency the chip runs at.
+ *
+ * @param asic_nr The chip number
+ * @param address The chip address
+ * @param target_frequency The target frequency in MHz
+ * @param set_frequency_fn Function pointer to the appropriate ASIC's send_chip_hash_frequency function
+ */
+void do_chip_frequency_transition(uint8_t asic_nr, uint8_t address, float target_frequency, set_chip_hash_frequency_fn set_frequency_fn);
+
 #endif // FREQUENCY_TRANSITION_H
@@ -0,0 +1,74 @@
+#ifndef NONCE_RANGE_H_
+#define NONCE_RANGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NONCE_RANGE_MAX_CHIPS 32
+
+// Nonce layout of the BM1368/BM1370 results: the counter of a core runs in the
+// low 17 bits, the chip address sits in bits 24..17 and the core id in 31..25.
+#define NONCE_RANGE_ADDRESS_SHIFT 17
+#define NONCE_RANGE_ADDRESS_SLOTS 256
+#define NONCE_RANGE_CORE_IDS 128
+
+// Register 0x10 value that reportedly lets the cores walk the full 32 bit nonce range
+#define NONCE_RANGE_FULL_HASH_COUNTING 0x000F0000
+
+typedef enum
+{
+    NONCE_RANGE_STOCK = 0, // hash counting value from the stock firmware dumps
+    NONCE_RANGE_FULL = 1,  // full 32 bit nonce range
+} nonce_range_mode;
+
+typedef struct
+{
+    nonce_range_mode mode;
+    uint32_t stock_hash_counting;
+    uint16_t small_core_count;
+    float frequency;
+    double job_interval_ms;
+
+    uint8_t chip_count;
+    // First address of each chip; the chip owns every address up to the next chip's
+    uint8_t chip_address[NONCE_RANGE_MAX_CHIPS];
+    uint16_t address_slots[NONCE_RANGE_MAX_CHIPS];
+    uint8_t chip_for_address[NONCE_RANGE_ADDRESS_SLOTS];
+    // Value written to register 0x10
+    uint32_t hash_counting;
+    // Time the chip with the largest share needs to exhaust it once
+    double sweep_ms;
+} nonce_range_plan;
+
+void nonce_range_plan_init(nonce_range_plan * plan, nonce_range_mode mode, uint32_t stock_hash_counting, uint16_t small_core_count,
+                           float frequency, double job_interval_ms);
+
+/**
+ * @brief Assign chip addresses and the register 0x10 value for the detected chips.
+ *
+ * Addresses are spread as floor(i * 256 / chip_count) so the 256 address slots
+ * of the nonce are covered without gaps, also when 256 is not a multiple of the
+ * chip count, and each chip owns a disjoint set of nonces.
+ */
+void nonce_range_plan_compute(nonce_range_plan * plan, uint8_t chip_count);
+
+/**
+ * @brief Assign the address layout chips were set up with before the nonce range plan.
+ *
+ * Addresses step by 256 / chip_count and register 0x10 keeps the stock value
+ * whatever the mode, for drivers whose chips were not verified with the
+ * gap-free layout or the full range.
+ */
+void nonce_range_plan_interval(nonce_range_plan * plan, uint8_t chip_count);
+
+// First nonce of the chip's share within each core id band
+uint32_t nonce_range_chip_start(const nonce_range_plan * plan, uint8_t chip);
+
+// Number of nonces the chip owns over all core ids
+uint64_t nonce_range_chip_size(const nonce_range_plan * plan, uint8_t chip);
+
+// Index of the chip that owns a chip address, or of the chip that found a nonce
+uint8_t nonce_range_chip_for_address(const nonce_range_plan * plan, uint8_t address);
+uint8_t nonce_range_chip_for_nonce(const nonce_range_plan * plan, uint32_t nonce);
+
+#endif /* NONCE_RANGE_H_ */
@@ -6,6 +6,9 @@
 
 #define FREQ_MULT 25.0 // MHz
 
+// Closest attainable frequency to the target and its PLL settings. The attainable
+// frequencies of the fb_divider range are tabulated on the first call, lookups are
+// a binary search.
 void pll_get_parameters(float target_freq, uint16_t fb_divider_min, uint16_t fb_divider_max, 
                         uint8_t *fb_divider, uint8_t *refdiv, uint8_t *postdiv1, uint8_t *postdiv2,
                         float *actual_freq);
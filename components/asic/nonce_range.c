@@ -0,0 +1,95 @@
+#include <string.h>
+#include "nonce_range.h"
+
+void nonce_range_plan_init(nonce_range_plan * plan, nonce_range_mode mode, uint32_t stock_hash_counting, uint16_t small_core_count,
+                           float frequency, double job_interval_ms)
+{
+    memset(plan, 0, sizeof(nonce_range_plan));
+    plan->mode = mode;
+    plan->stock_hash_counting = stock_hash_counting;
+    plan->small_core_count = small_core_count;
+    plan->frequency = frequency;
+    plan->job_interval_ms = job_interval_ms;
+}
+
+static uint8_t clamp_chip_count(uint8_t chip_count)
+{
+    if (chip_count == 0) {
+        return 1;
+    }
+    return chip_count > NONCE_RANGE_MAX_CHIPS ? NONCE_RANGE_MAX_CHIPS : chip_count;
+}
+
+static void assign_chip(nonce_range_plan * plan, uint8_t chip, int first, int next)
+{
+    plan->chip_address[chip] = first;
+    plan->address_slots[chip] = next - first;
+    for (int address = first; address < next; address++) {
+        plan->chip_for_address[address] = chip;
+    }
+}
+
+static void compute_sweep(nonce_range_plan * plan)
+{
+    uint16_t max_slots = 0;
+    for (int chip = 0; chip < plan->chip_count; chip++) {
+        if (plan->address_slots[chip] > max_slots) {
+            max_slots = plan->address_slots[chip];
+        }
+    }
+
+    // Every small core hashes one nonce per clock
+    double hashes_per_ms = (double) plan->small_core_count * plan->frequency * 1000.0;
+    double largest_share = (double) max_slots * NONCE_RANGE_CORE_IDS * (1 << NONCE_RANGE_ADDRESS_SHIFT);
+    plan->sweep_ms = hashes_per_ms > 0 ? largest_share / hashes_per_ms : 0;
+}
+
+void nonce_range_plan_compute(nonce_range_plan * plan, uint8_t chip_count)
+{
+    chip_count = clamp_chip_count(chip_count);
+    plan->chip_count = chip_count;
+
+    for (int chip = 0; chip < chip_count; chip++) {
+        assign_chip(plan, chip, chip * NONCE_RANGE_ADDRESS_SLOTS / chip_count, (chip + 1) * NONCE_RANGE_ADDRESS_SLOTS / chip_count);
+    }
+
+    plan->hash_counting = plan->mode == NONCE_RANGE_FULL ? NONCE_RANGE_FULL_HASH_COUNTING : plan->stock_hash_counting;
+    compute_sweep(plan);
+}
+
+void nonce_range_plan_interval(nonce_range_plan * plan, uint8_t chip_count)
+{
+    chip_count = clamp_chip_count(chip_count);
+    plan->chip_count = chip_count;
+    plan->mode = NONCE_RANGE_STOCK;
+
+    int interval = NONCE_RANGE_ADDRESS_SLOTS / chip_count;
+    for (int chip = 0; chip < chip_count; chip++) {
+        // The addresses past the last chip's interval are never used, they map to the last chip
+        int next = chip + 1 < chip_count ? (chip + 1) * interval : NONCE_RANGE_ADDRESS_SLOTS;
+        assign_chip(plan, chip, chip * interval, next);
+    }
+
+    plan->hash_counting = plan->stock_hash_counting;
+    compute_sweep(plan);
+}
+
+uint32_t nonce_range_chip_start(const nonce_range_plan * plan, uint8_t chip)
+{
+    return (uint32_t) plan->chip_address[chip] << NONCE_RANGE_ADDRESS_SHIFT;
+}
+
+uint64_t nonce_range_chip_size(const nonce_range_plan * plan, uint8_t chip)
+{
+    return (uint64_t) plan->address_slots[chip] * NONCE_RANGE_CORE_IDS << NONCE_RANGE_ADDRESS_SHIFT;
+}
+
+uint8_t nonce_range_chip_for_address(const nonce_range_plan * plan, uint8_t address)
+{
+    return plan->chip_for_address[address];
+}
+
+uint8_t nonce_range_chip_for_nonce(const nonce_range_plan * plan, uint32_t nonce)
+{
+    return plan->chip_for_address[(nonce >> NONCE_RANGE_ADDRESS_SHIFT) & 0xff];
+}
@@ -1,5 +1,4 @@
 #include <stdbool.h>
-#include <float.h>
 #include <math.h>
 
 #include "pll.h"
@@ -8,54 +7,198 @@
 
 #define EPSILON 0.0001f
 
+// Divider settings the PLL supports: refdiv 1..2, postdiv1 > postdiv2, both 1..7
+#define REFDIV_MAX 2
+#define POSTDIV_MAX 7
+#define DIVIDER_COUNT (REFDIV_MAX * POSTDIV_MAX * (POSTDIV_MAX - 1) / 2)
+
+// Enough for the fb_divider ranges of all supported chips (BM1397: 60..200 has 2304)
+#define PLL_TABLE_SIZE 2560
+
 static const char * TAG = "pll";
 
-void pll_get_parameters(float target_freq, uint16_t fb_divider_min, uint16_t fb_divider_max, 
-                        uint8_t *fb_divider, uint8_t *refdiv, uint8_t *postdiv1, uint8_t *postdiv2,
-                        float *actual_freq) 
-{
-    float best_freq = 0;
-    uint8_t best_refdiv = 0, best_fb_divider = 0, best_postdiv1 = 0, best_postdiv2 = 0;
-    float min_diff = FLT_MAX;
-    float min_vco_freq = FLT_MAX;
-    uint16_t min_postdiv = UINT16_MAX;
-
-    for (uint8_t refdiv = 2; refdiv > 0; refdiv--) {
-        for (uint8_t postdiv1 = 7; postdiv1 > 0; postdiv1--) {
-            for (uint8_t postdiv2 = 7; postdiv2 > 0; postdiv2--) {
-                uint16_t divider = refdiv * postdiv1 * postdiv2;
-                uint16_t fb_divider = round(target_freq / FREQ_MULT * divider);
-                if (postdiv1 > postdiv2 &&
-                    fb_divider >= fb_divider_min && fb_divider <= fb_divider_max) {
-                    float new_freq = FREQ_MULT * fb_divider / divider;
-                    float curr_diff = fabs(target_freq - new_freq);
-                    float vco_freq = FREQ_MULT * fb_divider / refdiv;
-                    // Prioritize: 
-                    // 1. Closest frequency to target
-                    // 2. Lowest VCO frequency
-                    // 3. Lowest postdiv1 * postdiv2
-                    if (curr_diff < min_diff ||
-                       (fabs(curr_diff - min_diff) < EPSILON && vco_freq < min_vco_freq) ||
-                       (fabs(curr_diff - min_diff) < EPSILON && fabs(vco_freq - min_vco_freq) < EPSILON && postdiv1 * postdiv2 < min_postdiv)) {
-                        min_diff = curr_diff;
-                        min_vco_freq = vco_freq;
-                        min_postdiv = postdiv1 * postdiv2;
-                        best_freq = new_freq;
-                        best_refdiv = refdiv;
-                        best_fb_divider = fb_divider;
-                        best_postdiv1 = postdiv1;
-                        best_postdiv2 = postdiv2;
-                    }
-                }
+typedef struct
+{
+    uint8_t fb_divider;
+    uint8_t divider_index;
+} pll_setting;
+
+typedef struct
+{
+    uint8_t refdiv;
+    uint8_t postdiv1;
+    uint8_t postdiv2;
+    uint8_t divider; // refdiv * postdiv1 * postdiv2
+} pll_divider;
+
+static pll_divider dividers[DIVIDER_COUNT];
+
+// Attainable frequencies of one fb_divider range in ascending order, each with
+// its preferred divider setting
+static pll_setting table[PLL_TABLE_SIZE];
+static uint16_t table_size;
+static uint16_t table_fb_divider_min;
+static uint16_t table_fb_divider_max;
+
+static float setting_frequency(pll_setting setting)
+{
+    const pll_divider * d = &dividers[setting.divider_index];
+    return FREQ_MULT * setting.fb_divider / d->divider;
+}
+
+// Orders two settings by frequency (compared exactly as fractions), then by the
+// preference for equal frequencies: lowest VCO frequency, lowest postdiv1 * postdiv2,
+// then highest refdiv and postdiv1 like the search used to. Negative when a comes first.
+static int compare_settings(pll_setting a, pll_setting b)
+{
+    const pll_divider * da = &dividers[a.divider_index];
+    const pll_divider * db = &dividers[b.divider_index];
+
+    int frequency = a.fb_divider * db->divider - b.fb_divider * da->divider;
+    if (frequency != 0) {
+        return frequency;
+    }
+    int vco = a.fb_divider * db->refdiv - b.fb_divider * da->refdiv;
+    if (vco != 0) {
+        return vco;
+    }
+    int postdiv = da->postdiv1 * da->postdiv2 - db->postdiv1 * db->postdiv2;
+    if (postdiv != 0) {
+        return postdiv;
+    }
+    if (da->refdiv != db->refdiv) {
+        return db->refdiv - da->refdiv;
+    }
+    return db->postdiv1 - da->postdiv1;
+}
+
+static void init_dividers(void)
+{
+    int i = 0;
+    for (uint8_t refdiv = 1; refdiv <= REFDIV_MAX; refdiv++) {
+        for (uint8_t postdiv1 = 1; postdiv1 <= POSTDIV_MAX; postdiv1++) {
+            for (uint8_t postdiv2 = 1; postdiv2 < postdiv1; postdiv2++) {
+                dividers[i++] = (pll_divider){refdiv, postdiv1, postdiv2, refdiv * postdiv1 * postdiv2};
             }
         }
     }
+}
+
+// Walks the attainable frequencies in ascending order by merging the fb_divider
+// range of every divider setting, which is already sorted. Returns the number of
+// distinct frequencies and stores the first capacity of them.
+static uint16_t generate(uint16_t fb_divider_min, uint16_t fb_divider_max, pll_setting * out, uint16_t capacity)
+{
+    uint16_t next_fb_divider[DIVIDER_COUNT];
+    for (int i = 0; i < DIVIDER_COUNT; i++) {
+        next_fb_divider[i] = fb_divider_min;
+    }
+
+    uint16_t count = 0;
+    while (true) {
+        // Lowest pending frequency, preferred setting first
+        int best = -1;
+        for (int i = 0; i < DIVIDER_COUNT; i++) {
+            if (next_fb_divider[i] > fb_divider_max) continue;
+            if (best < 0 || compare_settings((pll_setting){next_fb_divider[i], i}, (pll_setting){next_fb_divider[best], best}) < 0) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            return count;
+        }
+
+        pll_setting setting = {next_fb_divider[best], best};
+        if (count < capacity) {
+            out[count] = setting;
+        }
+        count++;
+
+        // Every other setting of the same frequency is dropped
+        for (int i = 0; i < DIVIDER_COUNT; i++) {
+            if (next_fb_divider[i] <= fb_divider_max &&
+                next_fb_divider[i] * dividers[best].divider == setting.fb_divider * dividers[i].divider) {
+                next_fb_divider[i]++;
+            }
+        }
+    }
+}
+
+static void build_table(uint16_t fb_divider_min, uint16_t fb_divider_max)
+{
+    if (table_size != 0 && table_fb_divider_min == fb_divider_min && table_fb_divider_max == fb_divider_max) {
+        return;
+    }
+
+    if (dividers[0].divider == 0) {
+        init_dividers();
+    }
+
+    uint16_t count = generate(fb_divider_min, fb_divider_max, table, PLL_TABLE_SIZE);
+    if (count > PLL_TABLE_SIZE) {
+        // The table keeps the lowest frequencies, higher targets get the highest of them
+        ESP_LOGW(TAG, "fb_divider %d..%d has %d frequencies, keeping the lowest %d", fb_divider_min, fb_divider_max, count, PLL_TABLE_SIZE);
+        count = PLL_TABLE_SIZE;
+    }
+    table_size = count;
+    table_fb_divider_min = fb_divider_min;
+    table_fb_divider_max = fb_divider_max;
+
+    ESP_LOGI(TAG, "%d frequencies for fb_divider %d..%d, highest %g MHz", table_size, fb_divider_min, fb_divider_max,
+             setting_frequency(table[table_size - 1]));
+}
+
+// Whether a is the better match for the target, preferring the closer frequency
+static bool closer(pll_setting a, pll_setting b, float target_freq)
+{
+    float diff_a = fabs(target_freq - setting_frequency(a));
+    float diff_b = fabs(target_freq - setting_frequency(b));
+    if (fabs(diff_a - diff_b) >= EPSILON) {
+        return diff_a < diff_b;
+    }
+
+    const pll_divider * da = &dividers[a.divider_index];
+    const pll_divider * db = &dividers[b.divider_index];
+    float vco_a = FREQ_MULT * a.fb_divider / da->refdiv;
+    float vco_b = FREQ_MULT * b.fb_divider / db->refdiv;
+    if (fabs(vco_a - vco_b) >= EPSILON) {
+        return vco_a < vco_b;
+    }
+    return da->postdiv1 * da->postdiv2 < db->postdiv1 * db->postdiv2;
+}
+
+void pll_get_parameters(float target_freq, uint16_t fb_divider_min, uint16_t fb_divider_max,
+                        uint8_t *fb_divider, uint8_t *refdiv, uint8_t *postdiv1, uint8_t *postdiv2,
+                        float *actual_freq)
+{
+    build_table(fb_divider_min, fb_divider_max);
+
+    // First frequency at or above the target, the best match is it or the one below
+    uint16_t low = 0, high = table_size;
+    while (low < high) {
+        uint16_t mid = (low + high) / 2;
+        if (setting_frequency(table[mid]) < target_freq) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    pll_setting best;
+    if (low == table_size) {
+        best = table[table_size - 1];
+    } else if (low > 0 && closer(table[low - 1], table[low], target_freq)) {
+        best = table[low - 1];
+    } else {
+        best = table[low];
+    }
 
-    ESP_LOGI(TAG, "Frequency: %g MHz (fb_divider: %d, refdiv: %d, postdiv1: %d, postdiv2: %d)", best_freq, best_fb_divider, best_refdiv, best_postdiv1, best_postdiv2);
+    const pll_divider * d = &dividers[best.divider_index];
+    *actual_freq = setting_frequency(best);
+    *fb_divider = best.fb_divider;
+    *refdiv = d->refdiv;
+    *postdiv1 = d->postdiv1;
+    *postdiv2 = d->postdiv2;
 
-    *actual_freq = best_freq;
-    *fb_divider = best_fb_divider;
-    *refdiv = best_refdiv;
-    *postdiv1 = best_postdiv1;
-    *postdiv2 = best_postdiv2;
+    ESP_LOGD(TAG, "Frequency: %g MHz (fb_divider: %d, refdiv: %d, postdiv1: %d, postdiv2: %d)", *actual_freq, *fb_divider, *refdiv, *postdiv1, *postdiv2);
 }
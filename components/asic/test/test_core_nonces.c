@@ -0,0 +1,87 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "core_nonces.h"
+
+static uint16_t chip_nonces[CORE_NONCES_CHIP_SIZE];
+
+// Spreads total over the small cores of a core
+static void set_core_total(uint8_t core_id, uint32_t total)
+{
+    for (int small_core_id = 0; small_core_id < CORE_NONCES_SMALL_CORES; small_core_id++) {
+        chip_nonces[core_id * CORE_NONCES_SMALL_CORES + small_core_id] =
+            total / CORE_NONCES_SMALL_CORES + (small_core_id < total % CORE_NONCES_SMALL_CORES);
+    }
+}
+
+static void set_chip(int core_count, uint32_t total)
+{
+    memset(chip_nonces, 0, sizeof(chip_nonces));
+    for (int core_id = 0; core_id < core_count; core_id++) {
+        set_core_total(core_id, total);
+    }
+}
+
+TEST_CASE("Core nonces flag a core only below 4 sigma of the average", "[core_nonces]")
+{
+    uint8_t low_cores[CORE_NONCES_CORES];
+
+    // 63 cores at 100 and one at 59: average 99.36, threshold 59.49
+    set_chip(64, 100);
+    set_core_total(17, 59);
+    TEST_ASSERT_EQUAL_UINT32(59, core_nonces_core_total(chip_nonces, 17));
+    TEST_ASSERT_EQUAL_INT(1, core_nonces_low_cores(chip_nonces, 64, low_cores, CORE_NONCES_CORES));
+    TEST_ASSERT_EQUAL_UINT8(17, low_cores[0]);
+
+    // At 60 the average is 99.38 and the threshold 59.50, the core is kept
+    set_core_total(17, 60);
+    TEST_ASSERT_EQUAL_INT(0, core_nonces_low_cores(chip_nonces, 64, low_cores, CORE_NONCES_CORES));
+
+    // The empty cores past core_count are not part of the chip
+    set_chip(64, 100);
+    TEST_ASSERT_EQUAL_INT(0, core_nonces_low_cores(chip_nonces, 64, low_cores, CORE_NONCES_CORES));
+}
+
+TEST_CASE("Core nonces judge no core before the average reaches the minimum", "[core_nonces]")
+{
+    uint8_t low_cores[CORE_NONCES_CORES];
+
+    // A dead core pulls the average of 80 cores at 20 nonces down to 19.75
+    set_chip(80, 20);
+    set_core_total(3, 0);
+    TEST_ASSERT_EQUAL_INT(0, core_nonces_low_cores(chip_nonces, 80, low_cores, CORE_NONCES_CORES));
+
+    // One more nonce per core lifts the average over the minimum
+    set_chip(80, 21);
+    set_core_total(3, 0);
+    TEST_ASSERT_EQUAL_INT(1, core_nonces_low_cores(chip_nonces, 80, low_cores, CORE_NONCES_CORES));
+    TEST_ASSERT_EQUAL_UINT8(3, low_cores[0]);
+}
+
+TEST_CASE("Core nonces report at most max_low_cores in core order", "[core_nonces]")
+{
+    uint8_t low_cores[2];
+
+    set_chip(128, 400);
+    set_core_total(5, 0);
+    set_core_total(9, 0);
+    set_core_total(100, 0);
+    TEST_ASSERT_EQUAL_INT(2, core_nonces_low_cores(chip_nonces, 128, low_cores, 2));
+    TEST_ASSERT_EQUAL_UINT8(5, low_cores[0]);
+    TEST_ASSERT_EQUAL_UINT8(9, low_cores[1]);
+}
+
+TEST_CASE("Core nonces halve the chip when a counter saturates", "[core_nonces]")
+{
+    memset(chip_nonces, 0, sizeof(chip_nonces));
+    chip_nonces[2 * CORE_NONCES_SMALL_CORES + 1] = UINT16_MAX;
+    chip_nonces[CORE_NONCES_CHIP_SIZE - 1] = 101;
+
+    core_nonces_add(chip_nonces, 2, 1);
+    TEST_ASSERT_EQUAL_UINT16(UINT16_MAX / 2 + 1, chip_nonces[2 * CORE_NONCES_SMALL_CORES + 1]);
+    TEST_ASSERT_EQUAL_UINT16(50, chip_nonces[CORE_NONCES_CHIP_SIZE - 1]);
+
+    core_nonces_add(chip_nonces, 127, 15);
+    TEST_ASSERT_EQUAL_UINT16(51, chip_nonces[CORE_NONCES_CHIP_SIZE - 1]);
+}
@@ -17,7 +17,7 @@ TEST_CASE("Check known working midstate + job command", "[bm1397]")
         SERIAL_init();
         uart_initialized = 1;
 
-        BM1397_init(425, 1, 256);
+        BM1397_init(425, 1, 256, NULL);
 
         // read back response
         SERIAL_debug_rx();
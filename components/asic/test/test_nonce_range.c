@@ -0,0 +1,87 @@
+#include "unity.h"
+
+#include "nonce_range.h"
+
+// Simulates every chip address slot of the nonce and checks that exactly one chip owns it
+static void check_coverage(uint8_t chip_count)
+{
+    nonce_range_plan plan;
+    nonce_range_plan_init(&plan, NONCE_RANGE_STOCK, 0x00001EB5, 2040, 525, 500.0 / chip_count);
+    nonce_range_plan_compute(&plan, chip_count);
+
+    TEST_ASSERT_EQUAL_UINT8(chip_count, plan.chip_count);
+
+    uint8_t owners[NONCE_RANGE_ADDRESS_SLOTS] = {0};
+    uint64_t total = 0;
+    for (int chip = 0; chip < chip_count; chip++) {
+        TEST_ASSERT_GREATER_THAN(0, plan.address_slots[chip]);
+        for (int slot = 0; slot < plan.address_slots[chip]; slot++) {
+            owners[plan.chip_address[chip] + slot]++;
+        }
+        total += nonce_range_chip_size(&plan, chip);
+
+        uint32_t start = nonce_range_chip_start(&plan, chip);
+        TEST_ASSERT_EQUAL_UINT8(chip, nonce_range_chip_for_nonce(&plan, start));
+        TEST_ASSERT_EQUAL_UINT8(chip, nonce_range_chip_for_nonce(&plan, start | 0xFE000000));
+        TEST_ASSERT_EQUAL_UINT8(chip, nonce_range_chip_for_address(&plan, plan.chip_address[chip]));
+    }
+
+    for (int slot = 0; slot < NONCE_RANGE_ADDRESS_SLOTS; slot++) {
+        TEST_ASSERT_EQUAL_UINT8(1, owners[slot]);
+        uint8_t chip = nonce_range_chip_for_address(&plan, slot);
+        TEST_ASSERT_TRUE(slot >= plan.chip_address[chip] && slot < plan.chip_address[chip] + plan.address_slots[chip]);
+    }
+    TEST_ASSERT_TRUE(total == 1ULL << 32);
+}
+
+TEST_CASE("Nonce range is split over the chips without gaps or overlap", "[nonce_range]")
+{
+    for (int chip_count = 1; chip_count <= NONCE_RANGE_MAX_CHIPS; chip_count++) {
+        check_coverage(chip_count);
+    }
+}
+
+TEST_CASE("Nonce range plan keeps the stock layout for power of two chains", "[nonce_range]")
+{
+    nonce_range_plan plan;
+    nonce_range_plan_init(&plan, NONCE_RANGE_STOCK, 0x000015A4, 1276, 490, 250);
+    nonce_range_plan_compute(&plan, 2);
+
+    TEST_ASSERT_EQUAL_UINT8(0, plan.chip_address[0]);
+    TEST_ASSERT_EQUAL_UINT8(128, plan.chip_address[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x01000000, nonce_range_chip_start(&plan, 1));
+    TEST_ASSERT_EQUAL_HEX32(0x000015A4, plan.hash_counting);
+}
+
+TEST_CASE("Nonce range plan selects register 0x10 and sweep time", "[nonce_range]")
+{
+    nonce_range_plan plan;
+    nonce_range_plan_init(&plan, NONCE_RANGE_FULL, 0x00001EB5, 2040, 525, 500);
+    nonce_range_plan_compute(&plan, 1);
+
+    TEST_ASSERT_EQUAL_HEX32(NONCE_RANGE_FULL_HASH_COUNTING, plan.hash_counting);
+    // 2^32 nonces at 2040 small cores * 525 MHz
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 4.01, plan.sweep_ms);
+
+    nonce_range_plan_compute(&plan, 0);
+    TEST_ASSERT_EQUAL_UINT8(1, plan.chip_count);
+}
+
+TEST_CASE("Nonce range interval layout keeps the stock addresses and register 0x10", "[nonce_range]")
+{
+    nonce_range_plan plan;
+    nonce_range_plan_init(&plan, NONCE_RANGE_FULL, 0x0000151C, 894, 485, 2000);
+    nonce_range_plan_interval(&plan, 6);
+
+    TEST_ASSERT_EQUAL_UINT8(6, plan.chip_count);
+    for (int chip = 0; chip < 6; chip++) {
+        TEST_ASSERT_EQUAL_UINT8(chip * 42, plan.chip_address[chip]);
+        TEST_ASSERT_EQUAL_UINT8(chip, nonce_range_chip_for_address(&plan, chip * 42));
+        TEST_ASSERT_EQUAL_UINT8(chip, nonce_range_chip_for_address(&plan, chip * 42 + 41));
+    }
+    TEST_ASSERT_EQUAL_UINT8(5, nonce_range_chip_for_address(&plan, 255));
+
+    // The full range is never written to these chips
+    TEST_ASSERT_EQUAL(NONCE_RANGE_STOCK, plan.mode);
+    TEST_ASSERT_EQUAL_HEX32(0x0000151C, plan.hash_counting);
+}
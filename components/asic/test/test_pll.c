@@ -1,7 +1,64 @@
+#include <float.h>
+#include <math.h>
+
 #include "unity.h"
 
 #include "pll.h"
 
+#define EPSILON 0.0001f
+
+// The exhaustive search pll_get_parameters used before the lookup table, kept to validate it
+static void search_parameters(float target_freq, uint16_t fb_divider_min, uint16_t fb_divider_max,
+                              uint8_t *fb_divider, uint8_t *refdiv, uint8_t *postdiv1, uint8_t *postdiv2,
+                              float *actual_freq)
+{
+    float best_freq = 0;
+    uint8_t best_refdiv = 0, best_fb_divider = 0, best_postdiv1 = 0, best_postdiv2 = 0;
+    float min_diff = FLT_MAX;
+    float min_vco_freq = FLT_MAX;
+    uint16_t min_postdiv = UINT16_MAX;
+
+    for (uint8_t refdiv = 2; refdiv > 0; refdiv--) {
+        for (uint8_t postdiv1 = 7; postdiv1 > 0; postdiv1--) {
+            for (uint8_t postdiv2 = 7; postdiv2 > 0; postdiv2--) {
+                uint16_t divider = refdiv * postdiv1 * postdiv2;
+                uint16_t fb_divider = round(target_freq / FREQ_MULT * divider);
+                if (postdiv1 > postdiv2 &&
+                    fb_divider >= fb_divider_min && fb_divider <= fb_divider_max) {
+                    float new_freq = FREQ_MULT * fb_divider / divider;
+                    float curr_diff = fabs(target_freq - new_freq);
+                    float vco_freq = FREQ_MULT * fb_divider / refdiv;
+                    // Prioritize:
+                    // 1. Closest frequency to target
+                    // 2. Lowest VCO frequency
+                    // 3. Lowest postdiv1 * postdiv2
+                    if (curr_diff < min_diff ||
+                       (fabs(curr_diff - min_diff) < EPSILON && vco_freq < min_vco_freq) ||
+                       (fabs(curr_diff - min_diff) < EPSILON && fabs(vco_freq - min_vco_freq) < EPSILON && postdiv1 * postdiv2 < min_postdiv)) {
+                        min_diff = curr_diff;
+                        min_vco_freq = vco_freq;
+                        min_postdiv = postdiv1 * postdiv2;
+                        best_freq = new_freq;
+                        best_refdiv = refdiv;
+                        best_fb_divider = fb_divider;
+                        best_postdiv1 = postdiv1;
+                        best_postdiv2 = postdiv2;
+                    }
+                }
+            }
+        }
+    }
+
+    *actual_freq = best_freq;
+    *fb_divider = best_fb_divider;
+    *refdiv = best_refdiv;
+    *postdiv1 = best_postdiv1;
+    *postdiv2 = best_postdiv2;
+}
+
+// fb_divider ranges of the BM1397, BM1366/BM1368 and BM1370
+static const uint16_t FB_DIVIDER_RANGES[][2] = {{60, 200}, {144, 235}, {160, 239}};
+
 TEST_CASE("Check PLL frequency calculation", "[pll]")
 {
     float frequency = 450.0; // MHz
@@ -16,3 +73,53 @@ TEST_CASE("Check PLL frequency calculation", "[pll]")
     TEST_ASSERT_EQUAL_UINT8(1, postdiv2);
     TEST_ASSERT_FLOAT_WITHIN(0.01, 450.0, actual_freq);
 }
+
+TEST_CASE("PLL lookup matches the search on the 6.25 MHz ramp grid", "[pll]")
+{
+    for (int r = 0; r < sizeof(FB_DIVIDER_RANGES) / sizeof(FB_DIVIDER_RANGES[0]); r++) {
+        for (int step = 8; step <= 200; step++) {
+            float frequency = step * 6.25f;
+            uint8_t fb_divider, refdiv, postdiv1, postdiv2;
+            uint8_t expected_fb_divider, expected_refdiv, expected_postdiv1, expected_postdiv2;
+            float actual_freq, expected_freq;
+
+            search_parameters(frequency, FB_DIVIDER_RANGES[r][0], FB_DIVIDER_RANGES[r][1],
+                              &expected_fb_divider, &expected_refdiv, &expected_postdiv1, &expected_postdiv2, &expected_freq);
+            if (expected_fb_divider == 0) {
+                continue; // out of range, the search finds nothing
+            }
+            pll_get_parameters(frequency, FB_DIVIDER_RANGES[r][0], FB_DIVIDER_RANGES[r][1],
+                               &fb_divider, &refdiv, &postdiv1, &postdiv2, &actual_freq);
+
+            TEST_ASSERT_EQUAL_UINT8(expected_fb_divider, fb_divider);
+            TEST_ASSERT_EQUAL_UINT8(expected_refdiv, refdiv);
+            TEST_ASSERT_EQUAL_UINT8(expected_postdiv1, postdiv1);
+            TEST_ASSERT_EQUAL_UINT8(expected_postdiv2, postdiv2);
+            TEST_ASSERT_EQUAL_FLOAT(expected_freq, actual_freq);
+        }
+    }
+}
+
+TEST_CASE("PLL lookup is never further from the target than the search", "[pll]")
+{
+    for (int r = 0; r < sizeof(FB_DIVIDER_RANGES) / sizeof(FB_DIVIDER_RANGES[0]); r++) {
+        for (int i = 0; i <= 20000; i++) {
+            float target = 50.0f + i * 0.05f;
+            uint8_t fb_divider, refdiv, postdiv1, postdiv2;
+            float actual_freq, expected_freq;
+
+            search_parameters(target, FB_DIVIDER_RANGES[r][0], FB_DIVIDER_RANGES[r][1],
+                              &fb_divider, &refdiv, &postdiv1, &postdiv2, &expected_freq);
+            if (fb_divider == 0) {
+                continue;
+            }
+            pll_get_parameters(target, FB_DIVIDER_RANGES[r][0], FB_DIVIDER_RANGES[r][1],
+                               &fb_divider, &refdiv, &postdiv1, &postdiv2, &actual_freq);
+
+            // Exact midpoints between two frequencies may resolve to either
+            TEST_ASSERT_TRUE(fabsf(target - actual_freq) < fabsf(target - expected_freq) + EPSILON);
+            TEST_ASSERT_FLOAT_WITHIN(0.01, FREQ_MULT * fb_divider / (refdiv * postdiv1 * postdiv2), actual_freq);
+            TEST_ASSERT_TRUE(postdiv1 > postdiv2);
+        }
+    }
+}
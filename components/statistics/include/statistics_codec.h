@@ -0,0 +1,97 @@
+#ifndef STATISTICS_CODEC_H_
+#define STATISTICS_CODEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per ASIC and per hash domain hashrate columns, only recorded when statsHashrateDetail is enabled
+#define STATS_MAX_ASICS 8
+#define STATS_MAX_DOMAINS 4
+
+// Columns of every row, the remaining ones are the detail columns of its layout
+#define STATS_COLUMN_COUNT 17
+#define STATS_MAX_COLUMN_COUNT (STATS_COLUMN_COUNT + STATS_MAX_ASICS * (1 + STATS_MAX_DOMAINS))
+
+// A block plus the 16 byte flash log header fills a 1 KiB flash slot
+#define STATS_BLOCK_SIZE 1008
+#define STATS_BLOCK_DATA_SIZE (STATS_BLOCK_SIZE - 20)
+#define STATS_BLOCK_BITS (STATS_BLOCK_DATA_SIZE * 8)
+
+// Detail columns of a row
+typedef struct
+{
+    uint8_t asic_count;
+    uint8_t hash_domains;
+} StatisticsLayout;
+
+// Rows of one layout. Each column is stored as the delta to the previous row
+// in a variable length bit code, timestamps as delta of the interval.
+typedef struct
+{
+    uint32_t sequence; // 0 when unused
+    uint32_t first_timestamp;
+    uint32_t last_timestamp;
+    uint16_t rows;
+    uint16_t bits;
+    StatisticsLayout layout;
+    uint16_t reserved;
+    uint8_t data[STATS_BLOCK_DATA_SIZE];
+} StatisticsBlock;
+
+// Ring of blocks holding one resolution. Samples are averaged over window_ms
+// before they are stored, a window of 0 stores every sample.
+typedef struct
+{
+    const uint32_t window_ms;
+    const uint16_t block_count;
+    StatisticsBlock * blocks;
+    uint32_t next_sequence;
+    bool open; // false until the first block of this boot is opened
+
+    // Encoder state of the newest block
+    uint32_t timestamp;
+    int32_t interval;
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+
+    // Downsampling window
+    int64_t sums[STATS_MAX_COLUMN_COUNT];
+    StatisticsLayout window_layout;
+    uint16_t count;
+    uint32_t window_start;
+    uint32_t window_end;
+} StatisticsRing;
+
+// Walks the rows of a ring from oldest to newest. Rows evicted in between are
+// skipped, the cursor continues at the oldest block still held.
+typedef struct
+{
+    uint32_t since;
+    uint32_t sequence;
+    uint16_t row;
+    uint16_t bit;
+    uint32_t timestamp;
+    int32_t interval;
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+} StatisticsCursor;
+
+int statistics_column_count(StatisticsLayout layout);
+bool statistics_same_layout(StatisticsLayout a, StatisticsLayout b);
+
+// Starts an empty ring on block_count zeroed blocks
+void statistics_ring_init(StatisticsRing * ring, StatisticsBlock * blocks);
+
+// Block holding sequence, NULL when it was evicted or never written
+StatisticsBlock * statistics_ring_block(const StatisticsRing * ring, uint32_t sequence);
+// Oldest sequence the ring can still hold
+uint32_t statistics_ring_oldest(const StatisticsRing * ring);
+
+// Adds one sample of statistics_column_count(layout) quantized values. A
+// layout change closes the downsampling window and the block early.
+void statistics_ring_add(StatisticsRing * ring, uint32_t timestamp, StatisticsLayout layout, const int32_t * values);
+
+void statistics_cursor_init(StatisticsCursor * cursor, uint32_t since);
+// Decodes the next row newer than since into cursor->timestamp and
+// cursor->values, false when there is none yet
+bool statistics_cursor_next(StatisticsCursor * cursor, const StatisticsRing * ring, StatisticsLayout * layout);
+
+#endif /* STATISTICS_CODEC_H_ */
@@ -0,0 +1,239 @@
+#include <string.h>
+#include <math.h>
+#include "statistics_codec.h"
+
+int statistics_column_count(StatisticsLayout layout)
+{
+    return STATS_COLUMN_COUNT + layout.asic_count * (1 + layout.hash_domains);
+}
+
+bool statistics_same_layout(StatisticsLayout a, StatisticsLayout b)
+{
+    return a.asic_count == b.asic_count && a.hash_domains == b.hash_domains;
+}
+
+static bool write_bits(StatisticsBlock * block, uint32_t value, uint8_t count)
+{
+    if (block->bits + count > STATS_BLOCK_BITS) {
+        return false;
+    }
+    for (int i = count - 1; i >= 0; i--) {
+        uint16_t bit = block->bits++;
+        if (value & (1u << i)) {
+            block->data[bit / 8] |= 0x80 >> (bit % 8);
+        } else {
+            block->data[bit / 8] &= ~(0x80 >> (bit % 8));
+        }
+    }
+    return true;
+}
+
+static uint32_t read_bits(const StatisticsBlock * block, uint16_t * bit, uint8_t count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++, (*bit)++) {
+        value = (value << 1) | ((block->data[*bit / 8] >> (7 - *bit % 8)) & 1);
+    }
+    return value;
+}
+
+// '0' no change, '10' 6 bit, '110' 12 bit, '1110' 20 bit, '1111' 32 bit two's complement delta
+static bool write_delta(StatisticsBlock * block, int32_t delta)
+{
+    if (delta == 0) return write_bits(block, 0b0, 1);
+    if (delta >= -32 && delta < 32) return write_bits(block, 0b10, 2) && write_bits(block, delta & 0x3F, 6);
+    if (delta >= -2048 && delta < 2048) return write_bits(block, 0b110, 3) && write_bits(block, delta & 0xFFF, 12);
+    if (delta >= -524288 && delta < 524288) return write_bits(block, 0b1110, 4) && write_bits(block, delta & 0xFFFFF, 20);
+    return write_bits(block, 0b1111, 4) && write_bits(block, (uint32_t)delta, 32);
+}
+
+// Deltas wrap around, a column that jumps across most of its range still round trips
+static int32_t wrapping_delta(int32_t value, int32_t previous)
+{
+    return (int32_t)((uint32_t)value - (uint32_t)previous);
+}
+
+static int32_t sign_extend(uint32_t value, uint8_t bits)
+{
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+static int32_t read_delta(const StatisticsBlock * block, uint16_t * bit)
+{
+    if (read_bits(block, bit, 1) == 0) return 0;
+    if (read_bits(block, bit, 1) == 0) return sign_extend(read_bits(block, bit, 6), 6);
+    if (read_bits(block, bit, 1) == 0) return sign_extend(read_bits(block, bit, 12), 12);
+    if (read_bits(block, bit, 1) == 0) return sign_extend(read_bits(block, bit, 20), 20);
+    return (int32_t)read_bits(block, bit, 32);
+}
+
+void statistics_ring_init(StatisticsRing * ring, StatisticsBlock * blocks)
+{
+    ring->blocks = blocks;
+    ring->next_sequence = 1;
+    ring->open = false;
+    ring->count = 0;
+}
+
+StatisticsBlock * statistics_ring_block(const StatisticsRing * ring, uint32_t sequence)
+{
+    StatisticsBlock * block = &ring->blocks[(sequence - 1) % ring->block_count];
+    return block->sequence == sequence ? block : NULL;
+}
+
+uint32_t statistics_ring_oldest(const StatisticsRing * ring)
+{
+    return ring->next_sequence > ring->block_count ? ring->next_sequence - ring->block_count : 1;
+}
+
+static void open_block(StatisticsRing * ring, uint32_t timestamp, StatisticsLayout layout)
+{
+    uint32_t sequence = ring->next_sequence++;
+    StatisticsBlock * block = &ring->blocks[(sequence - 1) % ring->block_count];
+
+    // Overwrites the oldest block once the ring is full
+    block->sequence = sequence;
+    block->first_timestamp = timestamp;
+    block->last_timestamp = timestamp;
+    block->rows = 0;
+    block->bits = 0;
+    block->layout = layout;
+
+    ring->open = true;
+    ring->timestamp = timestamp;
+    ring->interval = 0;
+    memset(ring->values, 0, sizeof(ring->values));
+}
+
+static bool encode_row(StatisticsRing * ring, StatisticsBlock * block, uint32_t timestamp, const int32_t * values)
+{
+    int32_t interval = timestamp - ring->timestamp;
+    if (!write_delta(block, interval - ring->interval)) return false;
+    for (int i = 0; i < statistics_column_count(block->layout); i++) {
+        if (!write_delta(block, wrapping_delta(values[i], ring->values[i]))) return false;
+    }
+
+    ring->timestamp = timestamp;
+    ring->interval = interval;
+    memcpy(ring->values, values, statistics_column_count(block->layout) * sizeof(int32_t));
+    block->last_timestamp = timestamp;
+    block->rows++;
+    return true;
+}
+
+static void append_row(StatisticsRing * ring, uint32_t timestamp, StatisticsLayout layout, const int32_t * values)
+{
+    // Restored blocks are not continued, the encoder state is not persisted
+    StatisticsBlock * block = NULL;
+    if (ring->open) {
+        block = statistics_ring_block(ring, ring->next_sequence - 1);
+    }
+
+    if (block != NULL && statistics_same_layout(block->layout, layout)) {
+        uint16_t bits = block->bits;
+        if (encode_row(ring, block, timestamp, values)) {
+            return;
+        }
+        block->bits = bits;
+    }
+
+    // A row always fits into an empty block
+    open_block(ring, timestamp, layout);
+    encode_row(ring, statistics_ring_block(ring, ring->next_sequence - 1), timestamp, values);
+}
+
+void statistics_ring_add(StatisticsRing * ring, uint32_t timestamp, StatisticsLayout layout, const int32_t * values)
+{
+    if (ring->window_ms == 0) {
+        append_row(ring, timestamp, layout, values);
+        return;
+    }
+
+    // A layout change closes the window early, averages never mix layouts
+    if (ring->count > 0 && (timestamp - ring->window_start >= ring->window_ms || !statistics_same_layout(ring->window_layout, layout))) {
+        int32_t average[STATS_MAX_COLUMN_COUNT];
+        for (int i = 0; i < statistics_column_count(ring->window_layout); i++) {
+            average[i] = llround((double)ring->sums[i] / ring->count);
+        }
+        append_row(ring, ring->window_end, ring->window_layout, average);
+        ring->count = 0;
+    }
+
+    if (ring->count == 0) {
+        memset(ring->sums, 0, sizeof(ring->sums));
+        ring->window_start = timestamp;
+        ring->window_layout = layout;
+    }
+    for (int i = 0; i < statistics_column_count(layout); i++) {
+        ring->sums[i] += values[i];
+    }
+    ring->window_end = timestamp;
+    ring->count++;
+}
+
+void statistics_cursor_init(StatisticsCursor * cursor, uint32_t since)
+{
+    memset(cursor, 0, sizeof(StatisticsCursor));
+    cursor->since = since;
+}
+
+static void start_block(StatisticsCursor * cursor, const StatisticsBlock * block)
+{
+    cursor->sequence = block->sequence;
+    cursor->row = 0;
+    cursor->bit = 0;
+    cursor->timestamp = block->first_timestamp;
+    cursor->interval = 0;
+    memset(cursor->values, 0, sizeof(cursor->values));
+}
+
+// Positions the cursor at the start of the oldest block with rows newer than since
+static void seek(StatisticsCursor * cursor, const StatisticsRing * ring)
+{
+    cursor->sequence = 0;
+    for (uint32_t sequence = statistics_ring_oldest(ring); sequence < ring->next_sequence; sequence++) {
+        const StatisticsBlock * block = statistics_ring_block(ring, sequence);
+        if (block != NULL && block->rows > 0 && block->last_timestamp > cursor->since) {
+            start_block(cursor, block);
+            return;
+        }
+    }
+}
+
+bool statistics_cursor_next(StatisticsCursor * cursor, const StatisticsRing * ring, StatisticsLayout * layout)
+{
+    // Restart from the oldest matching block when the current one was evicted
+    if (cursor->sequence == 0 || statistics_ring_block(ring, cursor->sequence) == NULL) {
+        seek(cursor, ring);
+    }
+
+    while (cursor->sequence != 0) {
+        const StatisticsBlock * block = statistics_ring_block(ring, cursor->sequence);
+
+        if (block == NULL || cursor->row >= block->rows) {
+            if (cursor->sequence + 1 >= ring->next_sequence) {
+                return false; // newest block, no more rows yet
+            }
+            cursor->sequence++;
+            block = statistics_ring_block(ring, cursor->sequence);
+            if (block == NULL) continue;
+            start_block(cursor, block);
+        }
+
+        cursor->interval += read_delta(block, &cursor->bit);
+        cursor->timestamp += cursor->interval;
+        for (int i = 0; i < statistics_column_count(block->layout); i++) {
+            cursor->values[i] = (int32_t)((uint32_t)cursor->values[i] + (uint32_t)read_delta(block, &cursor->bit));
+        }
+        cursor->row++;
+
+        if (cursor->timestamp > cursor->since) {
+            *layout = block->layout;
+            cursor->since = cursor->timestamp;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,193 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "statistics_codec.h"
+
+#define TEST_BLOCKS 3
+
+static StatisticsBlock blocks[TEST_BLOCKS];
+
+static const StatisticsLayout no_detail = {0, 0};
+
+static void init_ring(StatisticsRing * ring)
+{
+    memset(blocks, 0, sizeof(blocks));
+    statistics_ring_init(ring, blocks);
+}
+
+static void fill_row(int32_t values[STATS_MAX_COLUMN_COUNT], int32_t value)
+{
+    for (int i = 0; i < STATS_MAX_COLUMN_COUNT; i++) {
+        values[i] = value + i;
+    }
+}
+
+static void assert_row(const StatisticsCursor * cursor, StatisticsLayout layout, uint32_t timestamp, const int32_t * values)
+{
+    TEST_ASSERT_EQUAL_UINT32(timestamp, cursor->timestamp);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(values, cursor->values, statistics_column_count(layout));
+}
+
+TEST_CASE("Statistics rows round trip through every delta width", "[statistics]")
+{
+    StatisticsRing ring = {.window_ms = 0, .block_count = TEST_BLOCKS};
+    init_ring(&ring);
+
+    // Deltas of 0, the 6, 12, 20 and 32 bit codes at their limits, and -1
+    const int32_t targets[] = {0, 0, 31, -1, 2046, -2, 524285, -3, 524285, 0x40000000, -0x40000000, -0x40000000 - 1};
+    const int count = sizeof(targets) / sizeof(targets[0]);
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+
+    // Irregular intervals exercise the timestamp deltas as well
+    for (int row = 0; row < count; row++) {
+        fill_row(values, targets[row]);
+        statistics_ring_add(&ring, 5000 * (row + 1) + row * row * 37, no_detail, values);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, ring.next_sequence);
+
+    StatisticsCursor cursor;
+    StatisticsLayout layout;
+    statistics_cursor_init(&cursor, 0);
+    for (int row = 0; row < count; row++) {
+        TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &ring, &layout));
+        TEST_ASSERT_TRUE(statistics_same_layout(no_detail, layout));
+        fill_row(values, targets[row]);
+        assert_row(&cursor, layout, 5000 * (row + 1) + row * row * 37, values);
+    }
+    TEST_ASSERT_FALSE(statistics_cursor_next(&cursor, &ring, &layout));
+}
+
+TEST_CASE("Statistics rows continue in the next block once one is full", "[statistics]")
+{
+    StatisticsRing ring = {.window_ms = 0, .block_count = TEST_BLOCKS};
+    init_ring(&ring);
+
+    // Alternating 32 bit deltas make each row about 36 bytes
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+    int rows = 0;
+    while (ring.next_sequence < 3) {
+        fill_row(values, rows % 2 ? 0x40000000 : -0x40000000);
+        statistics_ring_add(&ring, 5000 * (rows + 1), no_detail, values);
+        rows++;
+    }
+
+    const StatisticsBlock * first = statistics_ring_block(&ring, 1);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_LESS_THAN(rows, first->rows);
+    TEST_ASSERT_LESS_OR_EQUAL(STATS_BLOCK_BITS, first->bits);
+    TEST_ASSERT_EQUAL_UINT32(5000 * first->rows, first->last_timestamp);
+
+    StatisticsCursor cursor;
+    StatisticsLayout layout;
+    statistics_cursor_init(&cursor, 0);
+    for (int row = 0; row < rows; row++) {
+        fill_row(values, row % 2 ? 0x40000000 : -0x40000000);
+        TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &ring, &layout));
+        assert_row(&cursor, layout, 5000 * (row + 1), values);
+    }
+    TEST_ASSERT_FALSE(statistics_cursor_next(&cursor, &ring, &layout));
+}
+
+TEST_CASE("Statistics layout change opens a block and closes the window", "[statistics]")
+{
+    StatisticsRing raw = {.window_ms = 0, .block_count = TEST_BLOCKS};
+    init_ring(&raw);
+
+    const StatisticsLayout detail = {.asic_count = 2, .hash_domains = 3};
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+
+    fill_row(values, 10);
+    statistics_ring_add(&raw, 5000, no_detail, values);
+    fill_row(values, 20);
+    statistics_ring_add(&raw, 10000, detail, values);
+    TEST_ASSERT_EQUAL_UINT32(3, raw.next_sequence);
+
+    StatisticsCursor cursor;
+    StatisticsLayout layout;
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &raw, &layout));
+    TEST_ASSERT_TRUE(statistics_same_layout(no_detail, layout));
+    fill_row(values, 10);
+    assert_row(&cursor, layout, 5000, values);
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &raw, &layout));
+    TEST_ASSERT_TRUE(statistics_same_layout(detail, layout));
+    TEST_ASSERT_EQUAL_INT(STATS_COLUMN_COUNT + 2 * 4, statistics_column_count(layout));
+    fill_row(values, 20);
+    assert_row(&cursor, layout, 10000, values);
+
+    // Averages are written at the end of their window and never mix layouts
+    StatisticsRing averaged = {.window_ms = 60000, .block_count = TEST_BLOCKS};
+    init_ring(&averaged);
+    fill_row(values, 10);
+    statistics_ring_add(&averaged, 5000, no_detail, values);
+    fill_row(values, 20);
+    statistics_ring_add(&averaged, 10000, no_detail, values);
+    fill_row(values, 100);
+    statistics_ring_add(&averaged, 15000, detail, values);
+    fill_row(values, 200);
+    statistics_ring_add(&averaged, 80000, detail, values);
+
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &averaged, &layout));
+    TEST_ASSERT_TRUE(statistics_same_layout(no_detail, layout));
+    fill_row(values, 15);
+    assert_row(&cursor, layout, 10000, values);
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &averaged, &layout));
+    TEST_ASSERT_TRUE(statistics_same_layout(detail, layout));
+    fill_row(values, 100);
+    assert_row(&cursor, layout, 15000, values);
+    // The last window is still open
+    TEST_ASSERT_FALSE(statistics_cursor_next(&cursor, &averaged, &layout));
+}
+
+TEST_CASE("Statistics cursor continues at the oldest block after an eviction", "[statistics]")
+{
+    StatisticsRing ring = {.window_ms = 0, .block_count = TEST_BLOCKS};
+    init_ring(&ring);
+
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+    uint32_t timestamp = 0;
+
+    fill_row(values, 0);
+    statistics_ring_add(&ring, timestamp += 5000, no_detail, values);
+    statistics_ring_add(&ring, timestamp += 5000, no_detail, values);
+
+    StatisticsCursor cursor;
+    StatisticsLayout layout;
+    statistics_cursor_init(&cursor, 0);
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &ring, &layout));
+    TEST_ASSERT_EQUAL_UINT32(5000, cursor.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1, cursor.sequence);
+
+    // Wrap the ring until the block the cursor is in has been overwritten
+    int row = 0;
+    while (statistics_ring_block(&ring, 1) != NULL) {
+        fill_row(values, row++ % 2 ? 0x40000000 : -0x40000000);
+        statistics_ring_add(&ring, timestamp += 5000, no_detail, values);
+    }
+
+    uint32_t oldest = statistics_ring_oldest(&ring);
+    const StatisticsBlock * block = statistics_ring_block(&ring, oldest);
+    TEST_ASSERT_NOT_NULL(block);
+
+    TEST_ASSERT_TRUE(statistics_cursor_next(&cursor, &ring, &layout));
+    TEST_ASSERT_EQUAL_UINT32(oldest, cursor.sequence);
+    TEST_ASSERT_EQUAL_UINT32(block->first_timestamp, cursor.timestamp);
+
+    // From there on every remaining row comes once, in order
+    uint32_t previous = cursor.timestamp;
+    int remaining = 1;
+    while (statistics_cursor_next(&cursor, &ring, &layout)) {
+        TEST_ASSERT_EQUAL_UINT32(previous + 5000, cursor.timestamp);
+        previous = cursor.timestamp;
+        remaining++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(timestamp, previous);
+
+    int held = 0;
+    for (uint32_t sequence = oldest; sequence < ring.next_sequence; sequence++) {
+        held += statistics_ring_block(&ring, sequence)->rows;
+    }
+    TEST_ASSERT_EQUAL_INT(held, remaining);
+}
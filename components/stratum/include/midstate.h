@@ -0,0 +1,32 @@
+#ifndef MIDSTATE_H_
+#define MIDSTATE_H_
+
+#include <stdint.h>
+
+#define MAX_MIDSTATES 4
+
+// First SHA-256 block of a header with everything but the version word pre-expanded.
+// Version rolling only changes W[0], so the rest of the message schedule is shared.
+typedef struct
+{
+    uint32_t w[16];
+    uint32_t partial[64]; // part of each expanded word that does not depend on W[0]
+    uint64_t w0_dependent; // bit t set when W[t] depends on W[0]
+} midstate_schedule;
+
+void midstate_schedule_init(midstate_schedule *schedule, const uint8_t block[64]);
+
+// Midstate for one version, in the same layout as midstate_sha256_bin
+void midstate_schedule_hash(const midstate_schedule *schedule, uint32_t version, uint8_t dest[32]);
+
+/**
+ * @brief Midstates for version, and count - 1 versions rolled through version_mask.
+ *
+ * The rolled versions share one message schedule. Rolled ntime jobs reuse the
+ * midstates of their template, so they are not generated again.
+ *
+ * @param block First 64 header bytes; the version field is ignored
+ */
+void midstate_generate(const uint8_t block[64], uint32_t version, uint32_t version_mask, int count, uint8_t dest[][32]);
+
+#endif /* MIDSTATE_H_ */
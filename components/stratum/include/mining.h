@@ -21,6 +21,7 @@ typedef struct
     uint32_t pool_diff;
     char *jobid;
     char *extranonce2;
+    uint32_t prevhash_epoch;
 } bm_job;
 
 void free_bm_job(bm_job *job);
@@ -36,6 +37,41 @@ double test_nonce_value(const bm_job *job, const uint32_t nonce, const uint32_t
 
 void extranonce_2_generate(uint64_t extranonce_2, uint32_t length, char dest[static length * 2 + 1]);
 
+#define MAX_EXTRANONCE_2_PARTITIONS 16
+
+typedef struct
+{
+    uint64_t start;      // first value of the partition
+    uint64_t size;       // number of values in the partition
+    uint64_t offset;     // randomized starting point inside the partition
+    uint64_t high_water; // values handed out so far this session
+} extranonce_2_range;
+
+// Hands out extranonce2 values without repeating them for the same extranonce1,
+// so work hashed before a reconnect is not hashed again afterwards.
+typedef struct
+{
+    char extranonce_str[65];
+    int extranonce_2_len;
+    int partitions;
+    extranonce_2_range ranges[MAX_EXTRANONCE_2_PARTITIONS];
+} extranonce_2_allocator;
+
+/**
+ * @brief Start or continue an extranonce2 session.
+ *
+ * The high-water marks are kept as long as extranonce1, extranonce2 length and
+ * partition count are unchanged. Otherwise the space is split into disjoint
+ * partitions, each starting at a point derived from seed.
+ *
+ * @return true if a new session was started
+ */
+bool extranonce_2_allocator_session(extranonce_2_allocator *allocator, const char *extranonce_str, int extranonce_2_len,
+                                    int partitions, uint64_t seed);
+
+// Next unused extranonce2 of a partition, wrapping only once its range is exhausted
+uint64_t extranonce_2_allocator_next(extranonce_2_allocator *allocator, int partition);
+
 uint32_t increment_bitmask(const uint32_t value, const uint32_t mask);
 
 #endif /* MINING_H_ */
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <stdbool.h>
 #include <sys/time.h>
 #include <esp_transport.h>
+#include "stratum_tls.h"
 
 #define MAX_MERKLE_BRANCHES 32
 #define HASH_SIZE 32
@@ -49,6 +50,8 @@ typedef struct
     uint32_t version;
     uint32_t target;
     uint32_t ntime;
+    // Prevhash epoch the notify belongs to, stamped by the stratum task when it is queued
+    uint32_t prevhash_epoch;
 } mining_notify;
 
 typedef struct
@@ -77,7 +80,7 @@ typedef struct {
     bool tracking;
 } RequestTiming;
 
-esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert);
+esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert, stratum_pool pool);
 
 void STRATUM_V1_initialize_buffer();
 
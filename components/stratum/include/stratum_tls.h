@@ -0,0 +1,47 @@
+#ifndef STRATUM_TLS_H
+#define STRATUM_TLS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_transport.h>
+
+typedef enum
+{
+    STRATUM_POOL_PRIMARY,
+    STRATUM_POOL_FALLBACK,
+    STRATUM_POOL_COUNT
+} stratum_pool;
+
+typedef struct
+{
+    // Handshakes done without a cached session or that the pool did not resume
+    uint32_t full_count;
+    float full_avg_ms;
+    // TLS 1.2 handshakes that resumed the cached session ticket / session ID
+    uint32_t resumed_count;
+    float resumed_avg_ms;
+    // TLS 1.3 handshakes that offered a cached ticket, mbedtls does not tell
+    // whether the pool accepted it
+    uint32_t unknown_count;
+    float unknown_avg_ms;
+    // Cached sessions the pool refused; they are dropped and the next connect is a full handshake
+    uint32_t resume_failures;
+    float last_ms;
+    bool last_resumed;
+} StratumTlsStats;
+
+/**
+ * @brief Create a TLS transport whose client session is cached per pool.
+ *
+ * The session is kept across close/connect cycles and across transports
+ * created for the same pool, so reconnects and failovers can resume instead
+ * of redoing the full handshake and certificate verification.
+ *
+ * @param cert PEM CA certificate, or NULL to use the bundled certificates
+ * @param pool Pool slot the session is cached under
+ */
+esp_transport_handle_t stratum_tls_transport_init(const char * cert, stratum_pool pool);
+
+void stratum_tls_get_stats(StratumTlsStats * stats);
+
+#endif // STRATUM_TLS_H
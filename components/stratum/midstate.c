@@ -0,0 +1,111 @@
+#include <string.h>
+#include <stdbool.h>
+#include "midstate.h"
+#include "mining.h"
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define S0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define s1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+void midstate_schedule_init(midstate_schedule *schedule, const uint8_t block[64])
+{
+    uint32_t *w = schedule->w;
+    for (int t = 0; t < 16; t++) {
+        w[t] = ((uint32_t)block[t * 4] << 24) | ((uint32_t)block[t * 4 + 1] << 16) | ((uint32_t)block[t * 4 + 2] << 8) |
+               (uint32_t)block[t * 4 + 3];
+    }
+
+    // Fold every term of W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16] that does not
+    // depend on W[0] into partial[t]; only the remaining terms are evaluated per version.
+    uint32_t expanded[64];
+    memcpy(expanded, w, sizeof(schedule->w));
+    uint64_t dependent = 1;
+    for (int t = 16; t < 64; t++) {
+        uint32_t partial = 0;
+        if (!(dependent >> (t - 2) & 1)) partial += s1(expanded[t - 2]);
+        if (!(dependent >> (t - 7) & 1)) partial += expanded[t - 7];
+        if (!(dependent >> (t - 15) & 1)) partial += s0(expanded[t - 15]);
+        if (!(dependent >> (t - 16) & 1)) partial += expanded[t - 16];
+
+        bool is_dependent = (dependent >> (t - 2) & 1) || (dependent >> (t - 7) & 1) || (dependent >> (t - 15) & 1) ||
+                            (dependent >> (t - 16) & 1);
+        if (is_dependent) {
+            dependent |= (uint64_t)1 << t;
+        }
+        schedule->partial[t] = partial;
+        expanded[t] = partial; // exact when independent, unused otherwise
+    }
+    schedule->w0_dependent = dependent;
+}
+
+void midstate_schedule_hash(const midstate_schedule *schedule, uint32_t version, uint8_t dest[32])
+{
+    uint32_t w[64];
+    memcpy(w, schedule->w, sizeof(schedule->w));
+    // The version is stored little endian in the header
+    w[0] = __builtin_bswap32(version);
+
+    uint64_t dependent = schedule->w0_dependent;
+    for (int t = 16; t < 64; t++) {
+        uint32_t word = schedule->partial[t];
+        if (dependent >> t & 1) {
+            if (dependent >> (t - 2) & 1) word += s1(w[t - 2]);
+            if (dependent >> (t - 7) & 1) word += w[t - 7];
+            if (dependent >> (t - 15) & 1) word += s0(w[t - 15]);
+            if (dependent >> (t - 16) & 1) word += w[t - 16];
+        }
+        w[t] = word;
+    }
+
+    uint32_t a = IV[0], b = IV[1], c = IV[2], d = IV[3], e = IV[4], f = IV[5], g = IV[6], h = IV[7];
+    for (int t = 0; t < 64; t++) {
+        uint32_t t1 = h + S1(e) + CH(e, f, g) + K[t] + w[t];
+        uint32_t t2 = S0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    uint32_t state[8] = {IV[0] + a, IV[1] + b, IV[2] + c, IV[3] + d, IV[4] + e, IV[5] + f, IV[6] + g, IV[7] + h};
+    memcpy(dest, state, 32);
+}
+
+void midstate_generate(const uint8_t block[64], uint32_t version, uint32_t version_mask, int count, uint8_t dest[][32])
+{
+    if (count > MAX_MIDSTATES) {
+        count = MAX_MIDSTATES;
+    }
+
+    midstate_schedule schedule;
+    midstate_schedule_init(&schedule, block);
+
+    uint32_t rolled_version = version;
+    for (int i = 0; i < count; i++) {
+        midstate_schedule_hash(&schedule, rolled_version, dest[i]);
+        rolled_version = increment_bitmask(rolled_version, version_mask);
+    }
+}
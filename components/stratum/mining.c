@@ -3,6 +3,7 @@
 #include <limits.h>
 #include "mining.h"
 #include "utils.h"
+#include "midstate.h"
 #include "mbedtls/sha256.h"
 #include "esp_log.h"
 
@@ -68,31 +69,18 @@ void construct_bm_job(mining_notify *params, const uint8_t merkle_root[32], cons
     memcpy(midstate_data + 4, prev_block_hash, 32);   // copy prev_block_hash
     memcpy(midstate_data + 36, merkle_root, 28);      // copy merkle_root
 
-    uint8_t midstate[32];
-    midstate_sha256_bin(midstate_data, 64, midstate); // make the midstate hash
-    reverse_32bit_words(midstate, new_job->midstate); // reverse the midstate words for the BM job packet
+    // all rolled versions share the message schedule of the last 60 bytes
+    new_job->num_midstates = version_mask != 0 ? MAX_MIDSTATES : 1;
+    uint8_t midstates[MAX_MIDSTATES][32];
+    midstate_generate(midstate_data, new_job->version, version_mask, new_job->num_midstates, midstates);
 
-    if (version_mask != 0)
+    // reverse the midstate words for the BM job packet
+    reverse_32bit_words(midstates[0], new_job->midstate);
+    if (new_job->num_midstates == MAX_MIDSTATES)
     {
-        uint32_t rolled_version = increment_bitmask(new_job->version, version_mask);
-        memcpy(midstate_data, &rolled_version, 4);
-        midstate_sha256_bin(midstate_data, 64, midstate);
-        reverse_32bit_words(midstate, new_job->midstate1);
-
-        rolled_version = increment_bitmask(rolled_version, version_mask);
-        memcpy(midstate_data, &rolled_version, 4);
-        midstate_sha256_bin(midstate_data, 64, midstate);
-        reverse_32bit_words(midstate, new_job->midstate2);
-
-        rolled_version = increment_bitmask(rolled_version, version_mask);
-        memcpy(midstate_data, &rolled_version, 4);
-        midstate_sha256_bin(midstate_data, 64, midstate);
-        reverse_32bit_words(midstate, new_job->midstate3);
-        new_job->num_midstates = 4;
-    }
-    else
-    {
-        new_job->num_midstates = 1;
+        reverse_32bit_words(midstates[1], new_job->midstate1);
+        reverse_32bit_words(midstates[2], new_job->midstate2);
+        reverse_32bit_words(midstates[3], new_job->midstate3);
     }
 }
 
@@ -111,6 +99,53 @@ void extranonce_2_generate(uint64_t extranonce_2, uint32_t length, char dest[sta
     bin2hex(extranonce_2_bytes, length, dest, length * 2 + 1);
 }
 
+bool extranonce_2_allocator_session(extranonce_2_allocator *allocator, const char *extranonce_str, int extranonce_2_len,
+                                    int partitions, uint64_t seed)
+{
+    if (partitions < 1) partitions = 1;
+    if (partitions > MAX_EXTRANONCE_2_PARTITIONS) partitions = MAX_EXTRANONCE_2_PARTITIONS;
+    if (extranonce_str == NULL) extranonce_str = "";
+
+    if (allocator->extranonce_2_len == extranonce_2_len && allocator->partitions == partitions &&
+        strncmp(allocator->extranonce_str, extranonce_str, sizeof(allocator->extranonce_str) - 1) == 0) {
+        return false;
+    }
+
+    strncpy(allocator->extranonce_str, extranonce_str, sizeof(allocator->extranonce_str) - 1);
+    allocator->extranonce_str[sizeof(allocator->extranonce_str) - 1] = '\0';
+    allocator->extranonce_2_len = extranonce_2_len;
+    allocator->partitions = partitions;
+
+    // Only the first 8 bytes are ever filled in by extranonce_2_generate
+    int bits = extranonce_2_len >= 8 ? 64 : extranonce_2_len * 8;
+    uint64_t size = bits == 64 ? UINT64_MAX / partitions : ((uint64_t)1 << bits) / partitions;
+    if (size == 0) size = 1;
+
+    for (int i = 0; i < partitions; i++) {
+        extranonce_2_range *range = &allocator->ranges[i];
+        range->start = size * i;
+        range->size = size;
+        // splitmix64 step, so every partition starts somewhere different
+        seed += 0x9e3779b97f4a7c15;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        range->offset = (z ^ (z >> 31)) % size;
+        range->high_water = 0;
+    }
+    return true;
+}
+
+uint64_t extranonce_2_allocator_next(extranonce_2_allocator *allocator, int partition)
+{
+    if (partition < 0 || partition >= allocator->partitions) partition = 0;
+
+    extranonce_2_range *range = &allocator->ranges[partition];
+    uint64_t value = range->start + (range->offset + range->high_water) % range->size;
+    range->high_water++;
+    return value;
+}
+
 ///////cgminer nonce testing
 /* truediffone == 0x00000000FFFF0000000000000000000000000000000000000000000000000000
  */
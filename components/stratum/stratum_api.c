@@ -10,9 +10,7 @@
 #include "esp_ota_ops.h"
 #include "esp_app_desc.h"
 #include "esp_transport.h"
-#include "esp_transport_ssl.h"
 #include "esp_transport_tcp.h"
-#include "esp_crt_bundle.h"
 #include "utils.h"
 #include "esp_timer.h"
 #include <stdio.h>
@@ -78,7 +76,7 @@ double STRATUM_V1_get_response_time_ms(int request_id)
 static void debug_stratum_tx(const char *);
 int _parse_stratum_subscribe_result_message(const char * result_json_str, char ** extranonce, int * extranonce2_len);
 
-esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert)
+esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert, stratum_pool pool)
 {
     esp_transport_handle_t transport;
     // tls_transport
@@ -89,17 +87,12 @@ esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert)
         transport = esp_transport_tcp_init();
     }
     else{
-        // tls_transport
+        // tls_transport, with the session cached per pool for resumption
         ESP_LOGI(TAG, "Using TLS transport");
-        transport = esp_transport_ssl_init();
-        if (transport == NULL) {
-            ESP_LOGE(TAG, "Failed to initialize SSL transport");
-            return NULL;
-        }
         switch(tls){
             case BUNDLED_CRT:
                 ESP_LOGI(TAG, "Using default cert bundle");
-                esp_transport_ssl_crt_bundle_attach(transport, esp_crt_bundle_attach);
+                transport = stratum_tls_transport_init(NULL, pool);
                 break;
             case CUSTOM_CRT:
                 ESP_LOGI(TAG, "Using custom cert");
@@ -107,13 +100,16 @@ esp_transport_handle_t STRATUM_V1_transport_init(tls_mode tls, char * cert)
                     ESP_LOGE(TAG, "Error: no TLS certificate");
                     return NULL;
                 }
-                esp_transport_ssl_set_cert_data(transport, cert, strlen(cert));
+                transport = stratum_tls_transport_init(cert, pool);
                 break;
             default:
                 ESP_LOGE(TAG, "Invalid TLS mode");
-                esp_transport_destroy(transport);
                 return NULL;
         }
+        if (transport == NULL) {
+            ESP_LOGE(TAG, "Failed to initialize SSL transport");
+            return NULL;
+        }
     }
     return transport;
 }
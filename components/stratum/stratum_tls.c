@@ -0,0 +1,365 @@
+#include "stratum_tls.h"
+#include "esp_log.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "esp_transport.h"
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+#include "mbedtls/ssl.h"
+#include "mbedtls/platform_util.h"
+#endif
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char * TAG = "stratum_tls";
+
+typedef enum
+{
+    HANDSHAKE_FULL,
+    HANDSHAKE_RESUMED,
+    HANDSHAKE_UNKNOWN,
+} handshake_type;
+
+typedef struct
+{
+    esp_tls_t * tls;
+    esp_tls_cfg_t cfg;
+    stratum_pool pool;
+    bool connected;
+    char host[128];
+    int port;
+} stratum_tls_ctx_t;
+
+typedef struct
+{
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    esp_tls_client_session_t * session;
+    // Master secret of a TLS 1.2 session, a resumption reuses it
+    unsigned char master[48];
+    bool has_master;
+#endif
+    char host[128];
+    int port;
+} stratum_tls_session_t;
+
+static stratum_tls_session_t sessions[STRATUM_POOL_COUNT];
+static StratumTlsStats stats;
+// Guards the cache only, a handshake takes its session out of the cache first
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+static void drop_session(stratum_tls_session_t * cached)
+{
+    if (cached->session != NULL) {
+        esp_tls_free_client_session(cached->session);
+        cached->session = NULL;
+    }
+    mbedtls_platform_zeroize(cached->master, sizeof(cached->master));
+    cached->has_master = false;
+}
+
+// Master secret of a TLS 1.2 connection. A TLS 1.2 resumption, by session ID
+// or by ticket, keeps the master secret of the offered session while a full
+// handshake derives a new one. The echoed session ID is no signal, with a
+// ticket the client sends a random one. TLS 1.3 keeps no master secret and
+// mbedtls does not tell whether the server accepted the offered ticket.
+static bool get_master(esp_tls_t * tls, unsigned char master[48])
+{
+    mbedtls_ssl_context * ssl = esp_tls_get_ssl_context(tls);
+    const mbedtls_ssl_session * session = ssl != NULL ? mbedtls_ssl_get_session_pointer(ssl) : NULL;
+    if (session == NULL || mbedtls_ssl_get_version_number(ssl) != MBEDTLS_SSL_VERSION_TLS1_2) {
+        return false;
+    }
+    memcpy(master, session->MBEDTLS_PRIVATE(master), 48);
+    return true;
+}
+
+// Moves the cached session out of the cache for a handshake, so nothing frees
+// it while it is offered. Must be called with session_lock held.
+static esp_tls_client_session_t * take_session(stratum_pool pool, const char * host, int port, unsigned char master[48], bool * has_master)
+{
+    stratum_tls_session_t * cached = &sessions[pool];
+    if (cached->session != NULL && (cached->port != port || strcmp(cached->host, host) != 0)) {
+        ESP_LOGI(TAG, "Pool %d changed to %s:%d, dropping cached session", pool, host, port);
+        drop_session(cached);
+    }
+
+    esp_tls_client_session_t * session = cached->session;
+    cached->session = NULL;
+    memcpy(master, cached->master, sizeof(cached->master));
+    *has_master = session != NULL && cached->has_master;
+    return session;
+}
+
+// Must be called with session_lock held
+static void store_session(stratum_tls_ctx_t * ctx)
+{
+    esp_tls_client_session_t * session = esp_tls_get_client_session(ctx->tls);
+    if (session == NULL) {
+        return;
+    }
+
+    stratum_tls_session_t * cached = &sessions[ctx->pool];
+    drop_session(cached);
+    cached->session = session;
+    cached->has_master = get_master(ctx->tls, cached->master);
+    strcpy(cached->host, ctx->host);
+    cached->port = ctx->port;
+}
+#endif
+
+static void record_handshake(handshake_type type, float elapsed_ms)
+{
+    pthread_mutex_lock(&stats_lock);
+    switch (type) {
+        case HANDSHAKE_FULL:
+            stats.full_count++;
+            stats.full_avg_ms += (elapsed_ms - stats.full_avg_ms) / stats.full_count;
+            break;
+        case HANDSHAKE_RESUMED:
+            stats.resumed_count++;
+            stats.resumed_avg_ms += (elapsed_ms - stats.resumed_avg_ms) / stats.resumed_count;
+            break;
+        case HANDSHAKE_UNKNOWN:
+            stats.unknown_count++;
+            stats.unknown_avg_ms += (elapsed_ms - stats.unknown_avg_ms) / stats.unknown_count;
+            break;
+    }
+    stats.last_ms = elapsed_ms;
+    stats.last_resumed = type == HANDSHAKE_RESUMED;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+static int stratum_tls_close(esp_transport_handle_t t)
+{
+    stratum_tls_ctx_t * ctx = esp_transport_get_context_data(t);
+    if (ctx->tls == NULL) {
+        return 0;
+    }
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // TLS 1.3 tickets arrive after the handshake, so the session is captured on close
+    if (ctx->connected) {
+        pthread_mutex_lock(&session_lock);
+        store_session(ctx);
+        pthread_mutex_unlock(&session_lock);
+    }
+#endif
+
+    int ret = esp_tls_conn_destroy(ctx->tls);
+    ctx->tls = NULL;
+    ctx->connected = false;
+    return ret;
+}
+
+static int stratum_tls_connect(esp_transport_handle_t t, const char * host, int port, int timeout_ms)
+{
+    stratum_tls_ctx_t * ctx = esp_transport_get_context_data(t);
+    stratum_tls_close(t);
+
+    ctx->tls = esp_tls_init();
+    if (ctx->tls == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate TLS context");
+        return -1;
+    }
+    ctx->cfg.timeout_ms = timeout_ms;
+    strncpy(ctx->host, host, sizeof(ctx->host) - 1);
+    ctx->host[sizeof(ctx->host) - 1] = '\0';
+    ctx->port = port;
+
+    handshake_type type = HANDSHAKE_FULL;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    unsigned char offered_master[48];
+    bool offered_has_master = false;
+    pthread_mutex_lock(&session_lock);
+    esp_tls_client_session_t * offered = take_session(ctx->pool, host, port, offered_master, &offered_has_master);
+    pthread_mutex_unlock(&session_lock);
+    ctx->cfg.client_session = offered;
+#endif
+
+    int64_t start_us = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(host, strlen(host), port, &ctx->cfg, ctx->tls);
+    float elapsed_ms = (esp_timer_get_time() - start_us) / 1000.0f;
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    ctx->cfg.client_session = NULL;
+    if (offered != NULL) {
+        if (ret > 0) {
+            unsigned char master[48];
+            if (get_master(ctx->tls, master)) {
+                type = offered_has_master && memcmp(master, offered_master, sizeof(master)) == 0 ? HANDSHAKE_RESUMED : HANDSHAKE_FULL;
+                mbedtls_platform_zeroize(master, sizeof(master));
+            } else if (!offered_has_master) {
+                // TLS 1.3 ticket offered, a TLS 1.2 session never resumes as TLS 1.3
+                type = HANDSHAKE_UNKNOWN;
+            }
+        }
+        mbedtls_platform_zeroize(offered_master, sizeof(offered_master));
+        esp_tls_free_client_session(offered);
+    }
+    if (ret > 0) {
+        pthread_mutex_lock(&session_lock);
+        store_session(ctx);
+        pthread_mutex_unlock(&session_lock);
+    }
+
+    if (ret <= 0 && offered != NULL) {
+        pthread_mutex_lock(&stats_lock);
+        stats.resume_failures++;
+        pthread_mutex_unlock(&stats_lock);
+    }
+#endif
+
+    if (ret <= 0) {
+        ESP_LOGE(TAG, "TLS handshake with %s:%d failed", host, port);
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+        return -1;
+    }
+
+    ctx->connected = true;
+    record_handshake(type, elapsed_ms);
+    static const char * type_names[] = {"Full", "Resumed", "TLS 1.3 ticket"};
+    ESP_LOGI(TAG, "%s handshake with %s:%d took %.1f ms", type_names[type], host, port, elapsed_ms);
+    return 0;
+}
+
+static int stratum_tls_poll(esp_transport_handle_t t, int timeout_ms, bool read)
+{
+    stratum_tls_ctx_t * ctx = esp_transport_get_context_data(t);
+    if (ctx->tls == NULL) {
+        return -1;
+    }
+    if (read && esp_tls_get_bytes_avail(ctx->tls) > 0) {
+        return 1;
+    }
+
+    int sockfd;
+    if (esp_tls_get_conn_sockfd(ctx->tls, &sockfd) != ESP_OK) {
+        return -1;
+    }
+
+    fd_set fdset, errset;
+    FD_ZERO(&fdset);
+    FD_SET(sockfd, &fdset);
+    FD_ZERO(&errset);
+    FD_SET(sockfd, &errset);
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+
+    int ret = select(sockfd + 1, read ? &fdset : NULL, read ? NULL : &fdset, &errset, timeout_ms >= 0 ? &timeout : NULL);
+    if (ret > 0 && FD_ISSET(sockfd, &errset)) {
+        ESP_LOGE(TAG, "Socket error on fd %d", sockfd);
+        return -1;
+    }
+    return ret;
+}
+
+static int stratum_tls_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    return stratum_tls_poll(t, timeout_ms, true);
+}
+
+static int stratum_tls_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    return stratum_tls_poll(t, timeout_ms, false);
+}
+
+static int stratum_tls_read(esp_transport_handle_t t, char * buffer, int len, int timeout_ms)
+{
+    stratum_tls_ctx_t * ctx = esp_transport_get_context_data(t);
+
+    int poll = stratum_tls_poll_read(t, timeout_ms);
+    if (poll <= 0) {
+        return poll == 0 ? ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT : ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+
+    int ret = esp_tls_conn_read(ctx->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_TIMEOUT) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    if (ret < 0) {
+        ESP_LOGE(TAG, "TLS read error: -0x%x", -ret);
+        return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+    return ret;
+}
+
+static int stratum_tls_write(esp_transport_handle_t t, const char * buffer, int len, int timeout_ms)
+{
+    stratum_tls_ctx_t * ctx = esp_transport_get_context_data(t);
+
+    int written = 0;
+    while (written < len) {
+        int poll = stratum_tls_poll_write(t, timeout_ms);
+        if (poll <= 0) {
+            ESP_LOGE(TAG, "TLS write poll %s", poll == 0 ? "timed out" : "failed");
+            return -1;
+        }
+
+        int ret = esp_tls_conn_write(ctx->tls, buffer + written, len - written);
+        if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret <= 0) {
+            ESP_LOGE(TAG, "TLS write error: -0x%x", -ret);
+            return -1;
+        }
+        written += ret;
+    }
+    return written;
+}
+
+static int stratum_tls_destroy(esp_transport_handle_t t)
+{
+    stratum_tls_close(t);
+    free(esp_transport_get_context_data(t));
+    return 0;
+}
+
+esp_transport_handle_t stratum_tls_transport_init(const char * cert, stratum_pool pool)
+{
+    if (pool >= STRATUM_POOL_COUNT) {
+        return NULL;
+    }
+
+    stratum_tls_ctx_t * ctx = calloc(1, sizeof(stratum_tls_ctx_t));
+    if (ctx == NULL) {
+        return NULL;
+    }
+    ctx->pool = pool;
+
+    if (cert == NULL) {
+        ctx->cfg.crt_bundle_attach = esp_crt_bundle_attach;
+    } else {
+        ctx->cfg.cacert_buf = (const unsigned char *) cert;
+        ctx->cfg.cacert_bytes = strlen(cert) + 1;
+    }
+
+    esp_transport_handle_t transport = esp_transport_init();
+    if (transport == NULL) {
+        free(ctx);
+        return NULL;
+    }
+
+    esp_transport_set_context_data(transport, ctx);
+    esp_transport_set_func(transport, stratum_tls_connect, stratum_tls_read, stratum_tls_write, stratum_tls_close,
+                           stratum_tls_poll_read, stratum_tls_poll_write, stratum_tls_destroy);
+    return transport;
+}
+
+void stratum_tls_get_stats(StratumTlsStats * out)
+{
+    pthread_mutex_lock(&stats_lock);
+    *out = stats;
+    pthread_mutex_unlock(&stats_lock);
+}
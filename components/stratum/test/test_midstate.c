@@ -0,0 +1,97 @@
+#include "unity.h"
+#include "midstate.h"
+#include "mining.h"
+#include "utils.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include <string.h>
+
+static const char * TAG = "test_midstate";
+
+static void fill_block(uint8_t block[64], uint8_t seed)
+{
+    for (int i = 0; i < 64; i++) {
+        block[i] = (uint8_t)(seed * 31 + i * 7);
+    }
+}
+
+TEST_CASE("Shared schedule midstate matches sha256 midstate", "[midstate]")
+{
+    uint8_t block[64];
+    fill_block(block, 1);
+
+    midstate_schedule schedule;
+    midstate_schedule_init(&schedule, block);
+
+    uint32_t version = 0x20000004;
+    for (int i = 0; i < MAX_MIDSTATES; i++) {
+        memcpy(block, &version, 4);
+        uint8_t expected[32];
+        midstate_sha256_bin(block, 64, expected);
+
+        uint8_t midstate[32];
+        midstate_schedule_hash(&schedule, version, midstate);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, midstate, 32);
+
+        version = increment_bitmask(version, STRATUM_DEFAULT_VERSION_MASK);
+    }
+}
+
+TEST_CASE("Generated midstates follow the rolled versions", "[midstate]")
+{
+    uint8_t block[64];
+    fill_block(block, 2);
+
+    uint8_t midstates[MAX_MIDSTATES][32];
+    midstate_generate(block, 0x20000004, STRATUM_DEFAULT_VERSION_MASK, MAX_MIDSTATES, midstates);
+
+    uint32_t version = 0x20000004;
+    for (int i = 0; i < MAX_MIDSTATES; i++) {
+        memcpy(block, &version, 4);
+        uint8_t expected[32];
+        midstate_sha256_bin(block, 64, expected);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, midstates[i], 32);
+        version = increment_bitmask(version, STRATUM_DEFAULT_VERSION_MASK);
+    }
+
+    // A different merkle root gives different midstates
+    uint8_t other[MAX_MIDSTATES][32];
+    block[63] ^= 0xff;
+    midstate_generate(block, 0x20000004, STRATUM_DEFAULT_VERSION_MASK, MAX_MIDSTATES, other);
+    TEST_ASSERT_FALSE(memcmp(midstates, other, sizeof(other)) == 0);
+}
+
+// Reports the speed only, wall-clock time is no pass criterion and means
+// nothing under QEMU
+TEST_CASE("Benchmark midstate generation", "[midstate][benchmark][not-on-qemu]")
+{
+    const int jobs = 500;
+    uint8_t block[64];
+    uint8_t midstates[MAX_MIDSTATES][32];
+    fill_block(block, 3);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < jobs; i++) {
+        block[40] = i;
+        block[41] = i >> 8;
+        uint32_t version = 0x20000004;
+        for (int j = 0; j < MAX_MIDSTATES; j++) {
+            memcpy(block, &version, 4);
+            midstate_sha256_bin(block, 64, midstates[j]);
+            version = increment_bitmask(version, STRATUM_DEFAULT_VERSION_MASK);
+        }
+    }
+    int64_t sequential_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < jobs; i++) {
+        block[40] = i;
+        block[41] = i >> 8;
+        midstate_generate(block, 0x20000004, STRATUM_DEFAULT_VERSION_MASK, MAX_MIDSTATES, midstates);
+    }
+    int64_t shared_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "Midstates x%d: sequential %.0f jobs/s, shared schedule %.0f jobs/s", MAX_MIDSTATES,
+             jobs * 1e6 / sequential_us, jobs * 1e6 / shared_us);
+}
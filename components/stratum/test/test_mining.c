@@ -232,3 +232,37 @@ TEST_CASE("Test nonce diff checking 2", "[mining test_nonce][not-on-qemu]")
     double diff = test_nonce_value(&job, nonce, 0);
     TEST_ASSERT_EQUAL_INT(683, (int)diff);
 }
+
+TEST_CASE("Extranonce 2 allocator keeps its high-water mark per session", "[mining extranonce2]")
+{
+    extranonce_2_allocator allocator = { 0 };
+    TEST_ASSERT_TRUE(extranonce_2_allocator_session(&allocator, "e9695791", 4, 1, 42));
+
+    uint64_t first = extranonce_2_allocator_next(&allocator, 0);
+    uint64_t second = extranonce_2_allocator_next(&allocator, 0);
+    TEST_ASSERT_TRUE(first <= UINT32_MAX);
+    TEST_ASSERT_TRUE(second == ((first + 1) & UINT32_MAX));
+
+    // Reconnect with the same extranonce1 continues where the session left off
+    TEST_ASSERT_FALSE(extranonce_2_allocator_session(&allocator, "e9695791", 4, 1, 7));
+    TEST_ASSERT_TRUE(extranonce_2_allocator_next(&allocator, 0) == ((first + 2) & UINT32_MAX));
+
+    // New extranonce1 starts a new session
+    TEST_ASSERT_TRUE(extranonce_2_allocator_session(&allocator, "00f2052a", 4, 1, 7));
+    TEST_ASSERT_TRUE(allocator.ranges[0].high_water == 0);
+}
+
+TEST_CASE("Extranonce 2 allocator partitions are disjoint", "[mining extranonce2]")
+{
+    extranonce_2_allocator allocator = { 0 };
+    extranonce_2_allocator_session(&allocator, "e9695791", 1, 4, 1234);
+
+    // 256 values in 4 partitions of 64, each wrapping inside its own range
+    for (int partition = 0; partition < 4; partition++) {
+        for (int i = 0; i < 100; i++) {
+            uint64_t value = extranonce_2_allocator_next(&allocator, partition);
+            TEST_ASSERT_TRUE(value >= (uint64_t)partition * 64);
+            TEST_ASSERT_TRUE(value < (uint64_t)(partition + 1) * 64);
+        }
+    }
+}
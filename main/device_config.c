@@ -80,3 +80,21 @@ esp_err_t device_config_init(void * pvParameters)
 
     return ESP_OK;
 }
+
+uint16_t device_config_lowest_frequency(const AsicConfig * asic)
+{
+    uint16_t lowest = asic->frequency_options[0];
+    for (int i = 1; asic->frequency_options[i] != 0; i++) {
+        if (asic->frequency_options[i] < lowest) lowest = asic->frequency_options[i];
+    }
+    return lowest;
+}
+
+uint16_t device_config_highest_frequency(const AsicConfig * asic)
+{
+    uint16_t highest = 0;
+    for (int i = 0; asic->frequency_options[i] != 0; i++) {
+        if (asic->frequency_options[i] > highest) highest = asic->frequency_options[i];
+    }
+    return highest;
+}
@@ -141,4 +141,8 @@ static const DeviceConfig default_configs[] = {
 
 esp_err_t device_config_init(void * pvParameters);
 
+// Lowest and highest of the frequency options of an ASIC in MHz
+uint16_t device_config_lowest_frequency(const AsicConfig * asic);
+uint16_t device_config_highest_frequency(const AsicConfig * asic);
+
 #endif /* DEVICE_CONFIG_H_ */
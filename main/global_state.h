@@ -7,6 +7,9 @@
 #include "common.h"
 #include "power_management_task.h"
 #include "hashrate_monitor_task.h"
+#include "autotune.h"
+#include "chip_frequency.h"
+#include "frequency_governor.h"
 #include "serial.h"
 #include "stratum_api.h"
 #include "work_queue.h"
@@ -35,7 +38,10 @@ typedef struct
     int64_t start_time;
     uint64_t shares_accepted;
     uint64_t shares_rejected;
+    uint64_t shares_stale_avoided;
     uint64_t work_received;
+    uint64_t jobs_generated;
+    uint64_t jobs_ntime_rolled;
     RejectedReasonStat rejected_reason_stats[10];
     int rejected_reason_stats_count;
     int screen_page;
@@ -105,10 +111,15 @@ typedef struct
     PowerManagementModule POWER_MANAGEMENT_MODULE;
     SelfTestModule SELF_TEST_MODULE;
     HashrateMonitorModule HASHRATE_MONITOR_MODULE;
+    AutotuneModule AUTOTUNE_MODULE;
+    ChipFrequencyModule CHIP_FREQUENCY_MODULE;
+    FrequencyGovernorModule FREQUENCY_GOVERNOR_MODULE;
 
     char * extranonce_str;
     int extranonce_2_len;
     int abandon_work;
+    // Bumped on every clean_jobs/prevhash change; jobs from an older epoch are stale
+    uint32_t prevhash_epoch;
 
     uint8_t * valid_jobs;
     pthread_mutex_t valid_jobs_lock;
@@ -1,12 +1,15 @@
 #include <string.h>
+#include <stdlib.h>
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "cJSON.h"
 #include "global_state.h"
 #include "asic.h"
+#include "hashrate_monitor_task.h"
 #include "http_server.h"
 
-static int system_asic_prebuffer_len = 256;
+static int system_asic_prebuffer_len = 512;
+static int system_asic_cores_prebuffer_len = 2048;
 
 // static const char *TAG = "asic_settings";
 static GlobalState *GLOBAL_STATE = NULL;
@@ -65,9 +68,117 @@ esp_err_t GET_system_asic(httpd_req_t *req)
     }
     cJSON_AddItemToObject(root, "voltageOptions", voltageOptions);
 
+    const nonce_range_plan * plan = ASIC_get_nonce_range_plan(GLOBAL_STATE);
+    if (plan != NULL) {
+        cJSON *nonceRange = cJSON_CreateObject();
+        cJSON_AddStringToObject(nonceRange, "mode", plan->mode == NONCE_RANGE_FULL ? "full" : "stock");
+        cJSON_AddNumberToObject(nonceRange, "hashCounting", plan->hash_counting);
+        cJSON_AddNumberToObject(nonceRange, "jobIntervalMs", plan->job_interval_ms);
+        cJSON_AddNumberToObject(nonceRange, "sweepMs", plan->sweep_ms);
+
+        cJSON *chips = cJSON_CreateArray();
+        for (int i = 0; i < plan->chip_count; i++) {
+            cJSON *chip = cJSON_CreateObject();
+            cJSON_AddNumberToObject(chip, "address", plan->chip_address[i]);
+            cJSON_AddNumberToObject(chip, "addressSlots", plan->address_slots[i]);
+            cJSON_AddNumberToObject(chip, "nonceStart", nonce_range_chip_start(plan, i));
+            cJSON_AddNumberToObject(chip, "nonceCount", nonce_range_chip_size(plan, i));
+            cJSON_AddItemToArray(chips, chip);
+        }
+        cJSON_AddItemToObject(nonceRange, "chips", chips);
+        cJSON_AddItemToObject(root, "nonceRange", nonceRange);
+    }
+
     esp_err_t res = HTTP_send_json(req, root, &system_asic_prebuffer_len);
 
     cJSON_Delete(root);
 
     return res;
 }
+
+/* Handler for system asic cores endpoint */
+esp_err_t GET_system_asic_cores(httpd_req_t *req)
+{
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+
+    // Set CORS headers
+    if (set_cors_headers(req) != ESP_OK) {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+
+    if (GLOBAL_STATE->HASHRATE_MONITOR_MODULE.core_nonces == NULL) {
+        return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Core statistics not available for this ASIC");
+    }
+
+    // Small core counts are only sent for the chip selected with ?asic=
+    int detail_asic = -1;
+    size_t buf_len = httpd_req_get_url_query_len(req) + 1;
+    if (buf_len > 1) {
+        char buf[buf_len];
+        char value[8];
+        if (httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK &&
+            httpd_query_key_value(buf, "asic", value, sizeof(value)) == ESP_OK) {
+            detail_asic = atoi(value);
+        }
+    }
+
+    int asic_count = GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+    int core_count = GLOBAL_STATE->DEVICE_CONFIG.family.asic.core_count;
+    if (core_count > CORE_NONCES_CORES) core_count = CORE_NONCES_CORES;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "coreCount", core_count);
+    cJSON_AddNumberToObject(root, "smallCoresPerCore", CORE_NONCES_SMALL_CORES);
+
+    cJSON *asics = cJSON_CreateArray();
+    for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+        cJSON *asic = cJSON_CreateObject();
+
+        uint32_t total = 0;
+        cJSON *cores = cJSON_CreateArray();
+        for (int core_id = 0; core_id < core_count; core_id++) {
+            uint32_t core_total = hashrate_monitor_core_total(GLOBAL_STATE, asic_nr, core_id);
+            cJSON_AddItemToArray(cores, cJSON_CreateNumber(core_total));
+            total += core_total;
+        }
+
+        uint8_t low_cores[CORE_NONCES_CORES];
+        int low_count = hashrate_monitor_low_cores(GLOBAL_STATE, asic_nr, low_cores, CORE_NONCES_CORES);
+        cJSON *lowCores = cJSON_CreateArray();
+        for (int i = 0; i < low_count; i++) {
+            cJSON_AddItemToArray(lowCores, cJSON_CreateNumber(low_cores[i]));
+        }
+
+        cJSON_AddNumberToObject(asic, "total", total);
+        cJSON_AddBoolToObject(asic, "anomaly", low_count > 0);
+        cJSON_AddItemToObject(asic, "lowCores", lowCores);
+        cJSON_AddItemToObject(asic, "cores", cores);
+
+        if (asic_nr == detail_asic) {
+            cJSON *smallCores = cJSON_CreateArray();
+            for (int core_id = 0; core_id < core_count; core_id++) {
+                uint16_t *small_core_nonces = hashrate_monitor_core_nonces(GLOBAL_STATE, asic_nr, core_id);
+                cJSON *core = cJSON_CreateArray();
+                for (int small_core_id = 0; small_core_id < CORE_NONCES_SMALL_CORES; small_core_id++) {
+                    cJSON_AddItemToArray(core, cJSON_CreateNumber(small_core_nonces[small_core_id]));
+                }
+                cJSON_AddItemToArray(smallCores, core);
+            }
+            cJSON_AddItemToObject(asic, "smallCores", smallCores);
+        }
+
+        cJSON_AddItemToArray(asics, asic);
+    }
+    cJSON_AddItemToObject(root, "asics", asics);
+
+    esp_err_t res = HTTP_send_json(req, root, &system_asic_cores_prebuffer_len);
+
+    cJSON_Delete(root);
+
+    return res;
+}
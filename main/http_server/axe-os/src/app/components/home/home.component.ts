@@ -83,6 +83,9 @@ export class HomeComponent implements OnInit, OnDestroy {
   private pageDefaultTitle: string = '';
   private destroy$ = new Subject<void>();
   private infoSubscription?: Subscription;
+  private statsSubscription?: Subscription;
+  // Statistics clock of the newest row on the chart, later polls only fetch the rows after it
+  private lastStatisticsTimestamp?: number;
   public form!: FormGroup;
 
   @Input() uri = '';
@@ -169,6 +172,8 @@ export class HomeComponent implements OnInit, OnDestroy {
       .subscribe({
         next: () => {
           this.infoSubscription?.unsubscribe();
+          this.statsSubscription?.unsubscribe();
+          this.statsSubscription = undefined;
           this.clearDataPoints();
           this.loadPreviousData();
         },
@@ -299,65 +304,102 @@ export class HomeComponent implements OnInit, OnDestroy {
     const chartY2DataLabel = this.form.get('chartY2Data')?.value;
 
     // load previous data
+    this.lastStatisticsTimestamp = undefined;
     this.stats$ = this.systemService.getStatistics(chartY1DataLabel, chartY2DataLabel)
       .pipe(shareReplay({ refCount: true, bufferSize: 1 }));
 
     this.stats$
       .pipe(takeUntil(this.destroy$))
       .subscribe(stats => {
-        let idxHashrate = -1;
-        let idxPower = -1;
-        let idxChartY1Data = -1;
-        let idxChartY2Data = -1;
-        let idxTimestamp = -1;
-
-        // map label to index
-        for (let i = 0; i < stats.labels.length; i++) {
-          if (stats.labels[i] === chartLabelKey(eChartLabel.hashrate)) { idxHashrate = i; }
-          if (stats.labels[i] === chartLabelKey(eChartLabel.power))    { idxPower = i; }
-          if (stats.labels[i] === chartY1DataLabel)                    { idxChartY1Data = i; }
-          if (stats.labels[i] === chartY2DataLabel)                    { idxChartY2Data = i; }
-          if (stats.labels[i] === 'timestamp')                         { idxTimestamp = i; }
-        }
+        this.appendStatistics(stats, chartY1DataLabel, chartY2DataLabel);
+        this.startGetLiveData();
+      });
+  }
 
-        stats.statistics.forEach(element => {
-          switch (chartLabelValue(chartY1DataLabel)) {
-            case eChartLabel.asicVoltage:
-            case eChartLabel.voltage:
-            case eChartLabel.current:
-              element[idxChartY1Data] = element[idxChartY1Data] / 1000;
-              break;
-            default:
-              break;
-          }
-          switch (chartLabelValue(chartY2DataLabel)) {
-            case eChartLabel.asicVoltage:
-            case eChartLabel.voltage:
-            case eChartLabel.current:
-              element[idxChartY2Data] = element[idxChartY2Data] / 1000;
-              break;
-            default:
-              break;
-          }
+  // Appends the rows newer than the last one on the chart. Row timestamps and
+  // currentTimestamp are both on the device's statistics clock, which starts
+  // at the restored history and not at boot.
+  private appendStatistics(stats: ISystemStatistics, chartY1DataLabel: string, chartY2DataLabel: string)
+  {
+    // The device restarted without its history, start over with what it has
+    if (this.lastStatisticsTimestamp !== undefined && stats.currentTimestamp < this.lastStatisticsTimestamp) {
+      this.clearDataPoints();
+      this.lastStatisticsTimestamp = undefined;
+      return;
+    }
 
-          this.dataLabel.push(new Date().getTime() - stats.currentTimestamp + element[idxTimestamp]);
-          this.hashrateData.push(element[idxHashrate]);
-          this.powerData.push(element[idxPower]);
-          if (-1 != idxChartY1Data) {
-            this.chartY1Data.push(element[idxChartY1Data]);
-          } else {
-            this.chartY1Data.push(0.0);
-          }
-          if (-1 != idxChartY2Data) {
-            this.chartY2Data.push(element[idxChartY2Data]);
-          } else {
-            this.chartY2Data.push(0.0);
-          }
+    let idxHashrate = -1;
+    let idxPower = -1;
+    let idxChartY1Data = -1;
+    let idxChartY2Data = -1;
+    let idxTimestamp = -1;
+
+    // map label to index
+    for (let i = 0; i < stats.labels.length; i++) {
+      if (stats.labels[i] === chartLabelKey(eChartLabel.hashrate)) { idxHashrate = i; }
+      if (stats.labels[i] === chartLabelKey(eChartLabel.power))    { idxPower = i; }
+      if (stats.labels[i] === chartY1DataLabel)                    { idxChartY1Data = i; }
+      if (stats.labels[i] === chartY2DataLabel)                    { idxChartY2Data = i; }
+      if (stats.labels[i] === 'timestamp')                         { idxTimestamp = i; }
+    }
 
-          this.limitDataPoints();
-        }),
-        this.startGetLiveData();
-      });
+    const clockOffset = new Date().getTime() - stats.currentTimestamp;
+
+    stats.statistics.forEach(element => {
+      if (this.lastStatisticsTimestamp !== undefined && element[idxTimestamp] <= this.lastStatisticsTimestamp) {
+        return;
+      }
+
+      switch (chartLabelValue(chartY1DataLabel)) {
+        case eChartLabel.asicVoltage:
+        case eChartLabel.voltage:
+        case eChartLabel.current:
+          element[idxChartY1Data] = element[idxChartY1Data] / 1000;
+          break;
+        default:
+          break;
+      }
+      switch (chartLabelValue(chartY2DataLabel)) {
+        case eChartLabel.asicVoltage:
+        case eChartLabel.voltage:
+        case eChartLabel.current:
+          element[idxChartY2Data] = element[idxChartY2Data] / 1000;
+          break;
+        default:
+          break;
+      }
+
+      this.dataLabel.push(clockOffset + element[idxTimestamp]);
+      this.hashrateData.push(element[idxHashrate]);
+      this.powerData.push(element[idxPower]);
+      if (-1 != idxChartY1Data) {
+        this.chartY1Data.push(element[idxChartY1Data]);
+      } else {
+        this.chartY1Data.push(0.0);
+      }
+      if (-1 != idxChartY2Data) {
+        this.chartY2Data.push(element[idxChartY2Data]);
+      } else {
+        this.chartY2Data.push(0.0);
+      }
+      this.lastStatisticsTimestamp = element[idxTimestamp];
+
+      this.limitDataPoints();
+    });
+  }
+
+  private startGetStatistics(statsFrequency: number)
+  {
+    const chartY1DataLabel = this.form.get('chartY1Data')?.value;
+    const chartY2DataLabel = this.form.get('chartY2Data')?.value;
+
+    this.statsSubscription = interval(Math.max(statsFrequency * 1000, 5000)).pipe(
+      switchMap(() => this.systemService.getStatistics(chartY1DataLabel, chartY2DataLabel, '', this.lastStatisticsTimestamp)),
+      takeUntil(this.destroy$)
+    ).subscribe(stats => {
+      this.appendStatistics(stats, chartY1DataLabel, chartY2DataLabel);
+      this.chart?.refresh();
+    });
   }
 
   private isHashrateAxis(label: eChartLabel | undefined) {
@@ -389,15 +431,26 @@ export class HomeComponent implements OnInit, OnDestroy {
         this.maxRpm = Math.max(7000, info.fanrpm, info.fan2rpm);
         this.maxFrequency = Math.max(800, info.frequency);
 
+        // While statistics are recorded the chart only fetches the new rows,
+        // otherwise it collects the live values
+        if (info.statsFrequency > 0 && !this.statsSubscription) {
+          this.startGetStatistics(info.statsFrequency);
+        } else if (info.statsFrequency == 0) {
+          this.statsSubscription?.unsubscribe();
+          this.statsSubscription = undefined;
+        }
+
         // Only collect and update chart data if there's no power fault
         if (!info.power_fault) {
-          this.dataLabel.push(new Date().getTime());
-          this.hashrateData.push(info.hashRate);
-          this.powerData.push(info.power);
-          this.chartY1Data.push(HomeComponent.getDataForLabel(chartY1DataLabel, info));
-          this.chartY2Data.push(HomeComponent.getDataForLabel(chartY2DataLabel, info));
-
-          this.limitDataPoints();
+          if (info.statsFrequency == 0) {
+            this.dataLabel.push(new Date().getTime());
+            this.hashrateData.push(info.hashRate);
+            this.powerData.push(info.power);
+            this.chartY1Data.push(HomeComponent.getDataForLabel(chartY1DataLabel, info));
+            this.chartY2Data.push(HomeComponent.getDataForLabel(chartY2DataLabel, info));
+
+            this.limitDataPoints();
+          }
 
           this.chartData.datasets[0].label = chartY1DataLabel;
           this.chartData.datasets[1].label = chartY2DataLabel;
@@ -2,7 +2,7 @@ import { AfterViewChecked, Component, Input, OnInit, ElementRef, OnDestroy, View
 import { FormBuilder, FormGroup, Validators } from '@angular/forms';
 import { Subscription } from 'rxjs';
 import { ToastrService } from 'ngx-toastr';
-import { WebsocketService } from 'src/app/services/web-socket.service';
+import { WebsocketService, LogLevel, decodeLogBatch, formatLogRecord } from 'src/app/services/web-socket.service';
 
 @Component({
   selector: 'app-logs',
@@ -54,31 +54,14 @@ export class LogsComponent implements OnInit, OnDestroy, AfterViewChecked {
   private subscribeLogs() {
     this.websocketSubscription = this.websocketService.ws$.subscribe({
         next: (val) => {
-          const matches = val.matchAll(/\[(\d+;\d+)m(.*?)(?=\[|\n|$)/g);
-          let className = 'ansi-white'; // default color
-
-          for (const match of matches) {
-            const colorCode = match[1].split(';')[1];
-            switch (colorCode) {
-              case '31': className = 'ansi-red'; break;
-              case '32': className = 'ansi-green'; break;
-              case '33': className = 'ansi-yellow'; break;
-              case '34': className = 'ansi-blue'; break;
-              case '35': className = 'ansi-magenta'; break;
-              case '36': className = 'ansi-cyan'; break;
-              case '37': className = 'ansi-white'; break;
-            }
+          if (typeof val === 'string') {
+            this.addLog(val, this.ansiClassName(val));
+            return;
           }
 
-          // Get current filter value from form
-          const currentFilter = this.form?.get('filter')?.value;
-
-          if (!currentFilter || val.includes(currentFilter)) {
-            this.logs.push({ className: `max-w-full font-monospace ${className}`, text: val });
-          }
-
-          if (this.logs.length > 256) {
-            this.logs.shift();
+          for (const record of decodeLogBatch(val)) {
+            const text = formatLogRecord(record);
+            this.addLog(text, record.level === LogLevel.Raw ? this.ansiClassName(text) : this.levelClassName(record.level));
           }
         },
         error: (error) => {
@@ -87,6 +70,48 @@ export class LogsComponent implements OnInit, OnDestroy, AfterViewChecked {
       })
   }
 
+  private addLog(text: string, className: string) {
+    // Get current filter value from form
+    const currentFilter = this.form?.get('filter')?.value;
+
+    if (!currentFilter || text.includes(currentFilter)) {
+      this.logs.push({ className: `max-w-full font-monospace ${className}`, text });
+    }
+
+    if (this.logs.length > 256) {
+      this.logs.shift();
+    }
+  }
+
+  private levelClassName(level: LogLevel): string {
+    switch (level) {
+      case LogLevel.Error: return 'ansi-red';
+      case LogLevel.Warn: return 'ansi-yellow';
+      case LogLevel.Info: return 'ansi-green';
+      default: return 'ansi-white';
+    }
+  }
+
+  private ansiClassName(val: string): string {
+    const matches = val.matchAll(/\[(\d+;\d+)m(.*?)(?=\[|\n|$)/g);
+    let className = 'ansi-white'; // default color
+
+    for (const match of matches) {
+      const colorCode = match[1].split(';')[1];
+      switch (colorCode) {
+        case '31': className = 'ansi-red'; break;
+        case '32': className = 'ansi-green'; break;
+        case '33': className = 'ansi-yellow'; break;
+        case '34': className = 'ansi-blue'; break;
+        case '35': className = 'ansi-magenta'; break;
+        case '36': className = 'ansi-cyan'; break;
+        case '37': className = 'ansi-white'; break;
+      }
+    }
+
+    return className;
+  }
+
   public clearLogs() {
     this.logs.length = 0;
   }
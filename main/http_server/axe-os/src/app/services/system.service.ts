@@ -59,6 +59,10 @@ export class SystemService {
         apEnabled: 0,
         sharesAccepted: 1,
         sharesRejected: 10,
+        sharesStaleAvoided: 3,
+        ntimeRollWindow: 0,
+        jobsGenerated: 52340,
+        jobsNtimeRolled: 0,
         sharesRejectedReasons: [
           { message: "Above target", count: 8 },
           { message: "Duplicate share", count: 2 }
@@ -82,9 +86,21 @@ export class SystemService {
         fallbackStratumCert: "",
         poolDifficulty: 1000,
         responseTime: 10,
+        tlsHandshakes: {
+          fullCount: 1,
+          fullAvgMs: 612.4,
+          resumedCount: 3,
+          resumedAvgMs: 148.9,
+          unknownCount: 0,
+          unknownAvgMs: 0,
+          resumeFailures: 0,
+          lastMs: 151.2,
+          lastResumed: true,
+        },
         isUsingFallbackStratum: false,
         poolConnectionInfo: "IPv4 (TLS)",
         frequency: 485,
+        frequencyActual: 485,
         version: "v2.12.0",
         axeOSVersion: "v2.12.0",
         idfVersion: "v5.5.1",
@@ -99,13 +115,28 @@ export class SystemService {
         fanspeed: 50,
         manualFanSpeed: 70,
         temptarget: 60,
+        fanFeedForward: 0,
+        thermalTimeConstant: 0,
         statsFrequency: 30,
+        statsHashrateDetail: 0,
         fanrpm: 3583,
         fan2rpm: 4146,
 
         boardtemp1: 30,
         boardtemp2: 40,
         overheat_mode: 0,
+        nonceRangeMode: 0,
+        autotuneMode: 0,
+        autotunePowerLimit: 0,
+        autotuneTempLimit: 65,
+        perChipFrequency: 0,
+        frequencyGovernor: 0,
+        powerCap: 0,
+        autotune: {
+          state: 'idle',
+          tuned: false,
+          pointsTested: 0,
+        },
 
         blockHeight: 811111,
         scriptsig: "..%..h..,H...ckpool.eu/solo.ckpool.org/",
@@ -115,6 +146,7 @@ export class SystemService {
             total: 441.2579,
             domains: [114.9901, 98.6658, 103.8136, 122.7133],
             errorCount: 4,
+            frequency: 485,
           }],
           hashrate: 441.2579,
         },
@@ -123,7 +155,7 @@ export class SystemService {
     ).pipe(delay(1000));
   }
 
-  public getStatistics(y1: string, y2: string, uri: string = ''): Observable<ISystemStatistics> {
+  public getStatistics(y1: string, y2: string, uri: string = '', since?: number, resolution?: 'raw' | '1m' | '10m'): Observable<ISystemStatistics> {
     let columnList = [chartLabelKey(eChartLabel.hashrate), chartLabelKey(eChartLabel.power)];
 
     if ((y1 != chartLabelKey(eChartLabel.hashrate)) && (y1 != chartLabelKey(eChartLabel.power))) {
@@ -134,7 +166,14 @@ export class SystemService {
     }
 
     if (environment.production) {
-      const options = { params: new HttpParams().set('columns', columnList.join(',')) };
+      let params = new HttpParams().set('columns', columnList.join(','));
+      if (since !== undefined) {
+        params = params.set('since', since);
+      }
+      if (resolution !== undefined) {
+        params = params.set('resolution', resolution);
+      }
+      const options = { params };
       return this.httpClient.get<ISystemStatistics>(`${uri}/api/system/statistics`, options).pipe(timeout(5000));
     }
 
@@ -262,7 +301,14 @@ export class SystemService {
       defaultFrequency: 485,
       frequencyOptions: [400, 425, 450, 475, 485, 500, 525, 550, 575],
       defaultVoltage: 1200,
-      voltageOptions: [1100, 1150, 1200, 1250, 1300]
+      voltageOptions: [1100, 1150, 1200, 1250, 1300],
+      nonceRange: {
+        mode: 'stock',
+        hashCounting: 7861,
+        jobIntervalMs: 500,
+        sweepMs: 4.01,
+        chips: [{ address: 0, addressSlots: 256, nonceStart: 0, nonceCount: 4294967296 }]
+      }
     }).pipe(delay(1000));
   }
 
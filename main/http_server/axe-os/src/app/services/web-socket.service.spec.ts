@@ -1,16 +1,32 @@
 import { TestBed } from '@angular/core/testing';
 
-import { WebSocketService } from './web-socket.service';
+import { WebsocketService, LogLevel, decodeLogBatch, formatLogRecord } from './web-socket.service';
 
-describe('WebSocketService', () => {
-  let service: WebSocketService;
+describe('WebsocketService', () => {
+  let service: WebsocketService;
 
   beforeEach(() => {
     TestBed.configureTestingModule({});
-    service = TestBed.inject(WebSocketService);
+    service = TestBed.inject(WebsocketService);
   });
 
   it('should be created', () => {
     expect(service).toBeTruthy();
   });
+
+  it('should decode a binary log batch', () => {
+    const bytes = new Uint8Array([
+      0x03, 0xd2, 0x04, 0x00, 0x00, 0x06, ...new TextEncoder().encode('bitaxe'), 0x08, 0x00, ...new TextEncoder().encode('hello 42'),
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, ...new TextEncoder().encode('raw line'),
+    ]);
+
+    const records = decodeLogBatch(bytes.buffer);
+
+    expect(records).toEqual([
+      { level: LogLevel.Info, timestamp: 1234, tag: 'bitaxe', message: 'hello 42' },
+      { level: LogLevel.Raw, timestamp: 0, tag: '', message: 'raw line' },
+    ]);
+    expect(formatLogRecord(records[0])).toBe('I (1234) bitaxe: hello 42');
+    expect(formatLogRecord(records[1])).toBe('raw line');
+  });
 });
@@ -1,16 +1,69 @@
 import { Injectable } from '@angular/core';
 import { webSocket, WebSocketSubject } from 'rxjs/webSocket';
 
+export enum LogLevel {
+  Raw = 0,
+  Error = 1,
+  Warn = 2,
+  Info = 3,
+  Debug = 4,
+  Verbose = 5
+}
+
+export interface ILogRecord {
+  level: LogLevel;
+  timestamp: number;
+  tag: string;
+  message: string;
+}
+
+const textDecoder = new TextDecoder();
+
+/**
+ * Decodes a binary log frame. Each record is
+ * u8 level, u32 timestamp ms, u8 tag length, tag, u16 message length, message (little endian).
+ */
+export function decodeLogBatch(buffer: ArrayBuffer): ILogRecord[] {
+  const view = new DataView(buffer);
+  const bytes = new Uint8Array(buffer);
+  const records: ILogRecord[] = [];
+
+  let offset = 0;
+  while (offset + 8 <= view.byteLength) {
+    const level = view.getUint8(offset);
+    const timestamp = view.getUint32(offset + 1, true);
+    const tagLength = view.getUint8(offset + 5);
+    const tag = textDecoder.decode(bytes.subarray(offset + 6, offset + 6 + tagLength));
+    offset += 6 + tagLength;
+
+    const messageLength = view.getUint16(offset, true);
+    const message = textDecoder.decode(bytes.subarray(offset + 2, offset + 2 + messageLength));
+    offset += 2 + messageLength;
+
+    records.push({ level, timestamp, tag, message });
+  }
+
+  return records;
+}
+
+export function formatLogRecord(record: ILogRecord): string {
+  if (record.level === LogLevel.Raw) {
+    return record.message;
+  }
+  return `${'?EWIDV'[record.level] ?? '?'} (${record.timestamp}) ${record.tag}: ${record.message}`;
+}
+
 @Injectable({
   providedIn: 'root'
 })
 export class WebsocketService {
 
-  public ws$: WebSocketSubject<string>;
+  public ws$: WebSocketSubject<string | ArrayBuffer>;
 
   constructor() {
     this.ws$ = webSocket({
       url: `ws://${window.location.host}/api/ws`,
+      binaryType: 'arraybuffer',
       deserializer: (e: MessageEvent) => { return e.data }
     });
   }
@@ -1,3 +1,18 @@
+export interface INonceRangeChip {
+  address: number;
+  addressSlots: number;
+  nonceStart: number;
+  nonceCount: number;
+}
+
+export interface INonceRange {
+  mode: 'stock' | 'full';
+  hashCounting: number;
+  jobIntervalMs: number;
+  sweepMs: number;
+  chips: INonceRangeChip[];
+}
+
 export interface ISystemASIC {
   ASICModel: string;
   deviceModel: string;
@@ -7,4 +22,5 @@ export interface ISystemASIC {
   frequencyOptions: number[];
   defaultVoltage: number;
   voltageOptions: number[];
+  nonceRange?: INonceRange;
 }
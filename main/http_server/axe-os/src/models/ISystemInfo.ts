@@ -7,12 +7,43 @@ interface IHashrateMonitorAsic {
     total: number;
     domains?: number[];
     errorCount: number;
+    frequency?: number;
+}
+
+interface ITlsHandshakes {
+    fullCount: number;
+    fullAvgMs: number;
+    resumedCount: number;
+    resumedAvgMs: number;
+    unknownCount: number;
+    unknownAvgMs: number;
+    resumeFailures: number;
+    lastMs: number;
+    lastResumed: boolean;
 }
 
 interface IHashrateMonitor {
     asics: IHashrateMonitorAsic[];
 }
 
+interface IAutotunePoint {
+    frequency: number;
+    voltage: number;
+    hashrate: number;
+    power: number;
+    errorPercentage: number;
+    temp: number;
+}
+
+interface IAutotune {
+    state: 'idle' | 'settling' | 'measuring' | 'applying' | 'done' | 'failed';
+    tuned: boolean;
+    pointsTested: number;
+    frequency?: number;
+    voltage?: number;
+    best?: IAutotunePoint;
+}
+
 export interface ISystemInfo {
     display: string;
     rotation: number;
@@ -48,6 +79,10 @@ export interface ISystemInfo {
     apEnabled: number,
     sharesAccepted: number,
     sharesRejected: number,
+    sharesStaleAvoided?: number,
+    ntimeRollWindow?: number,
+    jobsGenerated?: number,
+    jobsNtimeRolled?: number,
     sharesRejectedReasons: ISharesRejectedStat[];
     uptimeSeconds: number,
     smallCoreCount: number,
@@ -68,9 +103,11 @@ export interface ISystemInfo {
     fallbackStratumExtranonceSubscribe: number,
     poolDifficulty: number,
     responseTime: number,
+    tlsHandshakes?: ITlsHandshakes,
     isUsingFallbackStratum: boolean,
     poolConnectionInfo: string,
     frequency: number,
+    frequencyActual?: number,
     version: string,
     axeOSVersion: string,
     idfVersion: string,
@@ -81,9 +118,12 @@ export interface ISystemInfo {
     fanspeed: number,
     manualFanSpeed: number,
     temptarget: number,
+    fanFeedForward?: number,
+    thermalTimeConstant?: number,
     fanrpm: number,
     fan2rpm: number,
     statsFrequency: number,
+    statsHashrateDetail?: number,
     coreVoltageActual: number,
 
     boardtemp1?: number,
@@ -91,6 +131,14 @@ export interface ISystemInfo {
     overheat_mode: number,
     power_fault?: string,
     overclockEnabled?: number,
+    nonceRangeMode?: number,
+    autotuneMode?: number,
+    autotunePowerLimit?: number,
+    autotuneTempLimit?: number,
+    perChipFrequency?: number,
+    frequencyGovernor?: number,
+    powerCap?: number,
+    autotune?: IAutotune,
 
     blockHeight?: number,
     scriptsig?: string,
@@ -1,5 +1,6 @@
 export interface ISystemStatistics {
     currentTimestamp: number;
+    bootTimestamp?: number;
     labels: string[];
     statistics: number[][];
 }
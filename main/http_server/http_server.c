@@ -1,6 +1,8 @@
 #include <pthread.h>
 #include <fcntl.h>
+#include <stdarg.h>
 #include <string.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <math.h>
 #include <sys/param.h>
@@ -41,6 +43,7 @@
 #include "asic.h"
 #include "TPS546.h"
 #include "statistics_task.h"
+#include "sensor_task.h"
 #include "theme_api.h"  // Add theme API include
 #include "axe-os/api/system/asic_settings.h"
 #include "display.h"
@@ -70,11 +73,12 @@ static const char * STATS_LABEL_FAN2_RPM = "fan2Rpm";
 static const char * STATS_LABEL_WIFI_RSSI = "wifiRssi";
 static const char * STATS_LABEL_FREE_HEAP = "freeHeap";
 static const char * STATS_LABEL_RESPONSE_TIME = "responseTime";
+static const char * STATS_LABEL_ASIC_HASHRATE = "asicHashrate";
+static const char * STATS_LABEL_DOMAIN_HASHRATE = "domainHashrate";
 
 static const char * STATS_LABEL_TIMESTAMP = "timestamp";
 
 static int system_info_prebuffer_len = 256;
-static int system_statistics_prebuffer_len = 256;
 static int system_wifi_scan_prebuffer_len = 256;
 static int api_common_prebuffer_len = 256;
 
@@ -97,6 +101,9 @@ typedef enum
     SRC_WIFI_RSSI,
     SRC_FREE_HEAP,
     SRC_RESPONSE_TIME,
+    // Detail columns expand to one column per ASIC (and domain), only sent when requested
+    SRC_ASIC_HASHRATE,
+    SRC_DOMAIN_HASHRATE,
     SRC_NONE // last
 } DataSource;
 
@@ -120,10 +127,38 @@ DataSource strToDataSource(const char * sourceStr)
         if (strcmp(sourceStr, STATS_LABEL_WIFI_RSSI) == 0)    return SRC_WIFI_RSSI;
         if (strcmp(sourceStr, STATS_LABEL_FREE_HEAP) == 0)    return SRC_FREE_HEAP;
         if (strcmp(sourceStr, STATS_LABEL_RESPONSE_TIME) == 0) return SRC_RESPONSE_TIME;
+        if (strcmp(sourceStr, STATS_LABEL_ASIC_HASHRATE) == 0) return SRC_ASIC_HASHRATE;
+        if (strcmp(sourceStr, STATS_LABEL_DOMAIN_HASHRATE) == 0) return SRC_DOMAIN_HASHRATE;
     }
     return SRC_NONE;
 }
 
+const char * dataSourceToStr(DataSource source)
+{
+    switch (source) {
+        case SRC_HASHRATE:         return STATS_LABEL_HASHRATE;
+        case SRC_HASHRATE_1m:      return STATS_LABEL_HASHRATE_1m;
+        case SRC_HASHRATE_10m:     return STATS_LABEL_HASHRATE_10m;
+        case SRC_HASHRATE_1h:      return STATS_LABEL_HASHRATE_1h;
+        case SRC_ERROR_PERCENTAGE: return STATS_LABEL_ERROR_PERCENTAGE;
+        case SRC_ASIC_TEMP:        return STATS_LABEL_ASIC_TEMP;
+        case SRC_VR_TEMP:          return STATS_LABEL_VR_TEMP;
+        case SRC_ASIC_VOLTAGE:     return STATS_LABEL_ASIC_VOLTAGE;
+        case SRC_VOLTAGE:          return STATS_LABEL_VOLTAGE;
+        case SRC_POWER:            return STATS_LABEL_POWER;
+        case SRC_CURRENT:          return STATS_LABEL_CURRENT;
+        case SRC_FAN_SPEED:        return STATS_LABEL_FAN_SPEED;
+        case SRC_FAN_RPM:          return STATS_LABEL_FAN_RPM;
+        case SRC_FAN2_RPM:         return STATS_LABEL_FAN2_RPM;
+        case SRC_WIFI_RSSI:        return STATS_LABEL_WIFI_RSSI;
+        case SRC_FREE_HEAP:        return STATS_LABEL_FREE_HEAP;
+        case SRC_RESPONSE_TIME:    return STATS_LABEL_RESPONSE_TIME;
+        case SRC_ASIC_HASHRATE:    return STATS_LABEL_ASIC_HASHRATE;
+        case SRC_DOMAIN_HASHRATE:  return STATS_LABEL_DOMAIN_HASHRATE;
+        default:                   return NULL;
+    }
+}
+
 static GlobalState * GLOBAL_STATE;
 static httpd_handle_t server = NULL;
 
@@ -137,6 +172,90 @@ esp_err_t HTTP_send_json(httpd_req_t * req, const cJSON * item, int * prebuffer_
     return res;
 }
 
+void HTTP_stream_init(http_stream_t * stream, httpd_req_t * req)
+{
+    stream->req = req;
+    stream->len = 0;
+    stream->err = ESP_OK;
+}
+
+static void HTTP_stream_flush(http_stream_t * stream)
+{
+    if (stream->len > 0 && stream->err == ESP_OK) {
+        stream->err = httpd_resp_send_chunk(stream->req, stream->buffer, stream->len);
+    }
+    stream->len = 0;
+}
+
+void HTTP_stream_write(http_stream_t * stream, const char * data, size_t len)
+{
+    while (len > 0 && stream->err == ESP_OK) {
+        if (stream->len == HTTP_STREAM_BUFFER_SIZE) {
+            HTTP_stream_flush(stream);
+        }
+        size_t part = MIN(len, HTTP_STREAM_BUFFER_SIZE - stream->len);
+        memcpy(&stream->buffer[stream->len], data, part);
+        stream->len += part;
+        data += part;
+        len -= part;
+    }
+}
+
+void HTTP_stream_printf(http_stream_t * stream, const char * format, ...)
+{
+    if (stream->err != ESP_OK) return;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t available = HTTP_STREAM_BUFFER_SIZE - stream->len;
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(&stream->buffer[stream->len], available, format, args);
+        va_end(args);
+
+        if (len < 0) {
+            stream->err = ESP_FAIL;
+            return;
+        }
+        // vsnprintf needs room for the terminator, which is not sent
+        if (len < available) {
+            stream->len += len;
+            return;
+        }
+        HTTP_stream_flush(stream);
+    }
+
+    ESP_LOGE(TAG, "Stream write larger than %d bytes", HTTP_STREAM_BUFFER_SIZE);
+    stream->err = ESP_ERR_INVALID_SIZE;
+}
+
+void HTTP_stream_float(http_stream_t * stream, float number)
+{
+    double d_value = round((double)number * 10000000.0) / 10000000.0;
+
+    if (isnan(d_value) || isinf(d_value)) {
+        HTTP_stream_write(stream, "null", 4);
+        return;
+    }
+
+    // Same shortest round-trip formatting as cJSON
+    char number_buffer[26];
+    double test = 0.0;
+    snprintf(number_buffer, sizeof(number_buffer), "%1.15g", d_value);
+    if (sscanf(number_buffer, "%lg", &test) != 1 || test != d_value) {
+        snprintf(number_buffer, sizeof(number_buffer), "%1.17g", d_value);
+    }
+    HTTP_stream_write(stream, number_buffer, strlen(number_buffer));
+}
+
+esp_err_t HTTP_stream_end(http_stream_t * stream)
+{
+    HTTP_stream_flush(stream);
+    if (stream->err == ESP_OK) {
+        stream->err = httpd_resp_send_chunk(stream->req, NULL, 0);
+    }
+    return stream->err;
+}
+
 static const double FACTOR = 10000000.0;
 
 cJSON* cJSON_AddFloatToObject(cJSON * const object, const char * const name, const float number) {
@@ -819,10 +938,13 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     int8_t wifi_rssi = -90;
     get_wifi_current_rssi(&wifi_rssi);
 
+    SensorSnapshot sensors;
+    Sensor_get_snapshot(&sensors);
+
     cJSON * root = cJSON_CreateObject();
     cJSON_AddFloatToObject(root, "power", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.power);
     cJSON_AddFloatToObject(root, "voltage", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.voltage);
-    cJSON_AddFloatToObject(root, "current", Power_get_current(GLOBAL_STATE));
+    cJSON_AddFloatToObject(root, "current", sensors.current);
     cJSON_AddFloatToObject(root, "temp", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.chip_temp_avg);
     cJSON_AddFloatToObject(root, "temp2", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.chip_temp2_avg);
     cJSON_AddFloatToObject(root, "vrTemp", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.vr_temp);
@@ -849,8 +971,9 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     cJSON_AddNumberToObject(root, "freeHeapSpiram", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     
     cJSON_AddNumberToObject(root, "coreVoltage", nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE));
-    cJSON_AddNumberToObject(root, "coreVoltageActual", VCORE_get_voltage_mv(GLOBAL_STATE));
+    cJSON_AddNumberToObject(root, "coreVoltageActual", sensors.core_voltage);
     cJSON_AddNumberToObject(root, "frequency", frequency);
+    cJSON_AddFloatToObject(root, "frequencyActual", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value);
     cJSON_AddStringToObject(root, "ssid", ssid);
     cJSON_AddStringToObject(root, "macAddr", formattedMac);
     cJSON_AddStringToObject(root, "hostname", hostname);
@@ -861,6 +984,10 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     cJSON_AddNumberToObject(root, "apEnabled", GLOBAL_STATE->SYSTEM_MODULE.ap_enabled);
     cJSON_AddNumberToObject(root, "sharesAccepted", GLOBAL_STATE->SYSTEM_MODULE.shares_accepted);
     cJSON_AddNumberToObject(root, "sharesRejected", GLOBAL_STATE->SYSTEM_MODULE.shares_rejected);
+    cJSON_AddNumberToObject(root, "sharesStaleAvoided", GLOBAL_STATE->SYSTEM_MODULE.shares_stale_avoided);
+    cJSON_AddNumberToObject(root, "ntimeRollWindow", nvs_config_get_u16(NVS_CONFIG_NTIME_ROLL_WINDOW));
+    cJSON_AddNumberToObject(root, "jobsGenerated", GLOBAL_STATE->SYSTEM_MODULE.jobs_generated);
+    cJSON_AddNumberToObject(root, "jobsNtimeRolled", GLOBAL_STATE->SYSTEM_MODULE.jobs_ntime_rolled);
 
     cJSON *error_array = cJSON_CreateArray();
     cJSON_AddItemToObject(root, "sharesRejectedReasons", error_array);
@@ -891,6 +1018,20 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     cJSON_AddStringToObject(root, "fallbackStratumCert", fallbackStratumCert);
     cJSON_AddNumberToObject(root, "responseTime", GLOBAL_STATE->SYSTEM_MODULE.response_time);
 
+    StratumTlsStats tls_stats;
+    stratum_tls_get_stats(&tls_stats);
+    cJSON *tls_handshakes = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "tlsHandshakes", tls_handshakes);
+    cJSON_AddNumberToObject(tls_handshakes, "fullCount", tls_stats.full_count);
+    cJSON_AddFloatToObject(tls_handshakes, "fullAvgMs", tls_stats.full_avg_ms);
+    cJSON_AddNumberToObject(tls_handshakes, "resumedCount", tls_stats.resumed_count);
+    cJSON_AddFloatToObject(tls_handshakes, "resumedAvgMs", tls_stats.resumed_avg_ms);
+    cJSON_AddNumberToObject(tls_handshakes, "unknownCount", tls_stats.unknown_count);
+    cJSON_AddFloatToObject(tls_handshakes, "unknownAvgMs", tls_stats.unknown_avg_ms);
+    cJSON_AddNumberToObject(tls_handshakes, "resumeFailures", tls_stats.resume_failures);
+    cJSON_AddFloatToObject(tls_handshakes, "lastMs", tls_stats.last_ms);
+    cJSON_AddBoolToObject(tls_handshakes, "lastResumed", tls_stats.last_resumed);
+
     cJSON_AddStringToObject(root, "version", esp_app_get_description()->version);
     cJSON_AddStringToObject(root, "axeOSVersion", axeOSVersion);
 
@@ -901,6 +1042,13 @@ static esp_err_t GET_system_info(httpd_req_t * req)
 
     cJSON_AddNumberToObject(root, "overheat_mode", nvs_config_get_bool(NVS_CONFIG_OVERHEAT_MODE));
     cJSON_AddNumberToObject(root, "overclockEnabled", nvs_config_get_bool(NVS_CONFIG_OVERCLOCK_ENABLED));
+    cJSON_AddNumberToObject(root, "nonceRangeMode", nvs_config_get_u16(NVS_CONFIG_NONCE_RANGE_MODE));
+    cJSON_AddNumberToObject(root, "autotuneMode", nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_MODE));
+    cJSON_AddNumberToObject(root, "autotunePowerLimit", nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_POWER_LIMIT));
+    cJSON_AddNumberToObject(root, "autotuneTempLimit", nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_TEMP_LIMIT));
+    cJSON_AddNumberToObject(root, "perChipFrequency", nvs_config_get_bool(NVS_CONFIG_CHIP_FREQUENCY));
+    cJSON_AddNumberToObject(root, "frequencyGovernor", nvs_config_get_bool(NVS_CONFIG_FREQUENCY_GOVERNOR));
+    cJSON_AddNumberToObject(root, "powerCap", nvs_config_get_u16(NVS_CONFIG_POWER_CAP));
     cJSON_AddStringToObject(root, "display", display);
     cJSON_AddNumberToObject(root, "rotation", nvs_config_get_u16(NVS_CONFIG_ROTATION));
     cJSON_AddNumberToObject(root, "invertscreen", nvs_config_get_bool(NVS_CONFIG_INVERT_SCREEN));
@@ -912,10 +1060,13 @@ static esp_err_t GET_system_info(httpd_req_t * req)
     cJSON_AddNumberToObject(root, "manualFanSpeed", nvs_config_get_u16(NVS_CONFIG_MANUAL_FAN_SPEED));
     cJSON_AddNumberToObject(root, "minFanSpeed", nvs_config_get_u16(NVS_CONFIG_MIN_FAN_SPEED));
     cJSON_AddNumberToObject(root, "temptarget", nvs_config_get_u16(NVS_CONFIG_TEMP_TARGET));
+    cJSON_AddNumberToObject(root, "fanFeedForward", nvs_config_get_bool(NVS_CONFIG_FAN_FEED_FORWARD));
+    cJSON_AddFloatToObject(root, "thermalTimeConstant", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.thermal_time_constant);
     cJSON_AddNumberToObject(root, "fanrpm", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.fan_rpm);
     cJSON_AddNumberToObject(root, "fan2rpm", GLOBAL_STATE->POWER_MANAGEMENT_MODULE.fan2_rpm);
 
     cJSON_AddNumberToObject(root, "statsFrequency", nvs_config_get_u16(NVS_CONFIG_STATISTICS_FREQUENCY));
+    cJSON_AddNumberToObject(root, "statsHashrateDetail", nvs_config_get_bool(NVS_CONFIG_STATISTICS_HASHRATE_DETAIL));
 
     cJSON_AddNumberToObject(root, "blockFound", GLOBAL_STATE->SYSTEM_MODULE.block_found);
 
@@ -929,6 +1080,27 @@ static esp_err_t GET_system_info(httpd_req_t * req)
         cJSON_AddNumberToObject(root, "networkDifficulty", GLOBAL_STATE->network_nonce_diff);
     }
 
+    AutotuneModule * autotune_module = &GLOBAL_STATE->AUTOTUNE_MODULE;
+    cJSON *autotune = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "autotune", autotune);
+    cJSON_AddStringToObject(autotune, "state", Autotune_state_to_string(autotune_module->state));
+    cJSON_AddBoolToObject(autotune, "tuned", nvs_config_get_bool(NVS_CONFIG_AUTOTUNED));
+    cJSON_AddNumberToObject(autotune, "pointsTested", autotune_module->points_tested);
+    if (Autotune_is_running(GLOBAL_STATE)) {
+        cJSON_AddFloatToObject(autotune, "frequency", autotune_module->frequency);
+        cJSON_AddNumberToObject(autotune, "voltage", autotune_module->voltage);
+    }
+    if (autotune_module->best.hashrate > 0) {
+        cJSON *best = cJSON_CreateObject();
+        cJSON_AddItemToObject(autotune, "best", best);
+        cJSON_AddFloatToObject(best, "frequency", autotune_module->best.frequency);
+        cJSON_AddNumberToObject(best, "voltage", autotune_module->best.voltage);
+        cJSON_AddFloatToObject(best, "hashrate", autotune_module->best.hashrate);
+        cJSON_AddFloatToObject(best, "power", autotune_module->best.power);
+        cJSON_AddFloatToObject(best, "errorPercentage", autotune_module->best.error_percentage);
+        cJSON_AddFloatToObject(best, "temp", autotune_module->best.temperature);
+    }
+
     cJSON *hashrate_monitor = cJSON_CreateObject();
     cJSON_AddItemToObject(root, "hashrateMonitor", hashrate_monitor);
     
@@ -950,6 +1122,7 @@ static esp_err_t GET_system_info(httpd_req_t * req)
             cJSON_AddItemToObject(asic, "domains", hash_domain_array);
 
             cJSON_AddNumberToObject(asic, "errorCount", GLOBAL_STATE->HASHRATE_MONITOR_MODULE.error_measurement[asic_nr].value);
+            cJSON_AddFloatToObject(asic, "frequency", ChipFrequency_get(GLOBAL_STATE, asic_nr));
         }
     }
 
@@ -987,6 +1160,9 @@ static esp_err_t GET_system_statistics(httpd_req_t * req)
     size_t bufLen = httpd_req_get_url_query_len(req) + 1;
     bool dataSelection[SRC_NONE] = {false};
     bool selectionCheck = false;
+    // Only rows newer than this timestamp are sent
+    uint32_t since = 0;
+    StatisticsResolution resolution = STATS_RESOLUTION_RAW;
 
     // Check query parameters
     if (1 < bufLen) {
@@ -1004,75 +1180,262 @@ static esp_err_t GET_system_statistics(httpd_req_t * req)
                     param = strtok(NULL, ",");
                 }
             }
+            char sinceParam[12];
+            if (httpd_query_key_value(buf, "since", sinceParam, sizeof(sinceParam)) == ESP_OK) {
+                since = strtoul(sinceParam, NULL, 10);
+            }
+            char resolutionParam[8];
+            if (httpd_query_key_value(buf, "resolution", resolutionParam, sizeof(resolutionParam)) == ESP_OK) {
+                resolution = strToStatisticsResolution(resolutionParam);
+            }
         }
     }
 
     if (!selectionCheck) {
-        // Enable all
-        for (int i = 0; i < SRC_NONE; i++) {
+        // Enable all but the detail columns
+        for (int i = 0; i < SRC_ASIC_HASHRATE; i++) {
             dataSelection[i] = true;
         }
     }
 
-    // Create object for statistics
-    cJSON * root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "currentTimestamp", (esp_timer_get_time() / 1000));
-
-    cJSON * labelArray = cJSON_CreateArray();
-    if (dataSelection[SRC_HASHRATE]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_HASHRATE)); }
-    if (dataSelection[SRC_HASHRATE_1m]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_HASHRATE_1m)); }
-    if (dataSelection[SRC_HASHRATE_10m]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_HASHRATE_10m)); }
-    if (dataSelection[SRC_HASHRATE_1h]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_HASHRATE_1h)); }
-    if (dataSelection[SRC_ERROR_PERCENTAGE]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_ERROR_PERCENTAGE)); }
-    if (dataSelection[SRC_ASIC_TEMP]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_ASIC_TEMP)); }
-    if (dataSelection[SRC_VR_TEMP]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_VR_TEMP)); }
-    if (dataSelection[SRC_ASIC_VOLTAGE]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_ASIC_VOLTAGE)); }
-    if (dataSelection[SRC_VOLTAGE]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_VOLTAGE)); }
-    if (dataSelection[SRC_POWER]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_POWER)); }
-    if (dataSelection[SRC_CURRENT]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_CURRENT)); }
-    if (dataSelection[SRC_FAN_SPEED]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_FAN_SPEED)); }
-    if (dataSelection[SRC_FAN_RPM]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_FAN_RPM)); }
-    if (dataSelection[SRC_FAN2_RPM]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_FAN2_RPM)); }
-    if (dataSelection[SRC_WIFI_RSSI]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_WIFI_RSSI)); }
-    if (dataSelection[SRC_FREE_HEAP]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_FREE_HEAP)); }
-    if (dataSelection[SRC_RESPONSE_TIME]) { cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_RESPONSE_TIME)); }
-    cJSON_AddItemToArray(labelArray, cJSON_CreateString(STATS_LABEL_TIMESTAMP));
-
-    cJSON_AddItemToObject(root, "labels", labelArray);
-
-    cJSON * statsArray = cJSON_AddArrayToObject(root, "statistics");
+    int asicCount = MIN(GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, STATS_MAX_ASICS);
+    int hashDomains = MIN(GLOBAL_STATE->DEVICE_CONFIG.family.asic.hash_domains, STATS_MAX_DOMAINS);
+
+    http_stream_t stream;
+    HTTP_stream_init(&stream, req);
+
+    HTTP_stream_printf(&stream, "{\"currentTimestamp\":%" PRIu32 ",\"bootTimestamp\":%" PRIu32 ",\"labels\":[",
+                       getStatisticsTime(), getStatisticsBootTime());
+
+    for (int i = 0; i < SRC_ASIC_HASHRATE; i++) {
+        if (dataSelection[i]) {
+            HTTP_stream_printf(&stream, "\"%s\",", dataSourceToStr(i));
+        }
+    }
+    for (int asic = 0; dataSelection[SRC_ASIC_HASHRATE] && asic < asicCount; asic++) {
+        HTTP_stream_printf(&stream, "\"%s_%d\",", STATS_LABEL_ASIC_HASHRATE, asic);
+    }
+    for (int asic = 0; dataSelection[SRC_DOMAIN_HASHRATE] && asic < asicCount; asic++) {
+        for (int domain = 0; domain < hashDomains; domain++) {
+            HTTP_stream_printf(&stream, "\"%s_%d_%d\",", STATS_LABEL_DOMAIN_HASHRATE, asic, domain);
+        }
+    }
+    HTTP_stream_printf(&stream, "\"%s\"],\"statistics\":[", STATS_LABEL_TIMESTAMP);
+
     struct StatisticsData statsData;
-    uint16_t index = 0;
-
-    while (getStatisticData(index++, &statsData)) {
-        cJSON * valueArray = cJSON_CreateArray();
-        if (dataSelection[SRC_HASHRATE]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.hashrate)); }
-        if (dataSelection[SRC_HASHRATE_1m]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.hashrate_1m)); }
-        if (dataSelection[SRC_HASHRATE_10m]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.hashrate_10m)); }
-        if (dataSelection[SRC_HASHRATE_1h]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.hashrate_1h)); }
-        if (dataSelection[SRC_ERROR_PERCENTAGE]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.errorPercentage)); }
-        if (dataSelection[SRC_ASIC_TEMP]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.chipTemperature)); }
-        if (dataSelection[SRC_VR_TEMP]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.vrTemperature)); }
-        if (dataSelection[SRC_ASIC_VOLTAGE]) { cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.coreVoltageActual)); }
-        if (dataSelection[SRC_VOLTAGE]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.voltage)); }
-        if (dataSelection[SRC_POWER]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.power)); }
-        if (dataSelection[SRC_CURRENT]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.current)); }
-        if (dataSelection[SRC_FAN_SPEED]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.fanSpeed)); }
-        if (dataSelection[SRC_FAN_RPM]) { cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.fanRPM)); }
-        if (dataSelection[SRC_FAN2_RPM]) { cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.fan2RPM)); }
-        if (dataSelection[SRC_WIFI_RSSI]) { cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.wifiRSSI)); }
-        if (dataSelection[SRC_FREE_HEAP]) { cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.freeHeap)); }
-        if (dataSelection[SRC_RESPONSE_TIME]) { cJSON_AddItemToArray(valueArray, cJSON_CreateFloat(statsData.responseTime)); }
-        cJSON_AddItemToArray(valueArray, cJSON_CreateNumber(statsData.timestamp));
-
-        cJSON_AddItemToArray(statsArray, valueArray);
-    }
-
-    esp_err_t res = HTTP_send_json(req, root, &system_statistics_prebuffer_len);
+    StatisticsIterator iterator;
+    bool first = true;
+
+    initStatisticIterator(&iterator, resolution, since);
+    while (stream.err == ESP_OK && nextStatisticData(&iterator, &statsData)) {
+        HTTP_stream_write(&stream, first ? "[" : ",[", first ? 1 : 2);
+        first = false;
+
+        if (dataSelection[SRC_HASHRATE]) { HTTP_stream_float(&stream, statsData.hashrate); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_HASHRATE_1m]) { HTTP_stream_float(&stream, statsData.hashrate_1m); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_HASHRATE_10m]) { HTTP_stream_float(&stream, statsData.hashrate_10m); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_HASHRATE_1h]) { HTTP_stream_float(&stream, statsData.hashrate_1h); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_ERROR_PERCENTAGE]) { HTTP_stream_float(&stream, statsData.errorPercentage); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_ASIC_TEMP]) { HTTP_stream_float(&stream, statsData.chipTemperature); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_VR_TEMP]) { HTTP_stream_float(&stream, statsData.vrTemperature); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_ASIC_VOLTAGE]) { HTTP_stream_printf(&stream, "%d,", statsData.coreVoltageActual); }
+        if (dataSelection[SRC_VOLTAGE]) { HTTP_stream_float(&stream, statsData.voltage); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_POWER]) { HTTP_stream_float(&stream, statsData.power); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_CURRENT]) { HTTP_stream_float(&stream, statsData.current); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_FAN_SPEED]) { HTTP_stream_float(&stream, statsData.fanSpeed); HTTP_stream_write(&stream, ",", 1); }
+        if (dataSelection[SRC_FAN_RPM]) { HTTP_stream_printf(&stream, "%u,", statsData.fanRPM); }
+        if (dataSelection[SRC_FAN2_RPM]) { HTTP_stream_printf(&stream, "%u,", statsData.fan2RPM); }
+        if (dataSelection[SRC_WIFI_RSSI]) { HTTP_stream_printf(&stream, "%d,", statsData.wifiRSSI); }
+        if (dataSelection[SRC_FREE_HEAP]) { HTTP_stream_printf(&stream, "%" PRIu32 ",", statsData.freeHeap); }
+        if (dataSelection[SRC_RESPONSE_TIME]) { HTTP_stream_float(&stream, statsData.responseTime); HTTP_stream_write(&stream, ",", 1); }
+        // Rows recorded without detail get null, stored values are 0.1 GH/s
+        for (int asic = 0; dataSelection[SRC_ASIC_HASHRATE] && asic < asicCount; asic++) {
+            if (asic < statsData.asicCount) {
+                HTTP_stream_float(&stream, statsData.asicHashrate[asic] / 10.0f);
+                HTTP_stream_write(&stream, ",", 1);
+            } else {
+                HTTP_stream_write(&stream, "null,", 5);
+            }
+        }
+        for (int asic = 0; dataSelection[SRC_DOMAIN_HASHRATE] && asic < asicCount; asic++) {
+            for (int domain = 0; domain < hashDomains; domain++) {
+                if (asic < statsData.asicCount && domain < statsData.hashDomains) {
+                    HTTP_stream_float(&stream, statsData.domainHashrate[asic][domain] / 10.0f);
+                    HTTP_stream_write(&stream, ",", 1);
+                } else {
+                    HTTP_stream_write(&stream, "null,", 5);
+                }
+            }
+        }
+        HTTP_stream_printf(&stream, "%" PRIu32 "]", statsData.timestamp);
+    }
 
-    cJSON_Delete(root);
+    HTTP_stream_write(&stream, "]}", 2);
 
-    return res;
+    return HTTP_stream_end(&stream);
+}
+
+#define METRICS_PREFIX "bitaxe_"
+
+static void metrics_family(http_stream_t * stream, const char * name, const char * type, const char * help)
+{
+    HTTP_stream_printf(stream, "# TYPE " METRICS_PREFIX "%s %s\n# HELP " METRICS_PREFIX "%s %s\n", name, type, name, help);
+}
+
+static void metrics_value(http_stream_t * stream, float value)
+{
+    // OpenMetrics spells missing values as NaN and infinities as +Inf/-Inf where JSON would use null
+    if (isnan(value)) {
+        HTTP_stream_write(stream, " NaN\n", 5);
+        return;
+    }
+    if (isinf(value)) {
+        HTTP_stream_printf(stream, " %cInf\n", value > 0 ? '+' : '-');
+        return;
+    }
+    HTTP_stream_write(stream, " ", 1);
+    HTTP_stream_float(stream, value);
+    HTTP_stream_write(stream, "\n", 1);
+}
+
+// Writes one sample line, series is the metric name without prefix plus optional labels
+static void metrics_sample(http_stream_t * stream, const char * series, float value)
+{
+    HTTP_stream_printf(stream, METRICS_PREFIX "%s", series);
+    metrics_value(stream, value);
+}
+
+static void metrics_gauge(http_stream_t * stream, const char * name, const char * help, float value)
+{
+    metrics_family(stream, name, "gauge", help);
+    metrics_sample(stream, name, value);
+}
+
+// Integer gauges that a float would round, like share difficulties
+static void metrics_gauge_u64(http_stream_t * stream, const char * name, const char * help, uint64_t value)
+{
+    metrics_family(stream, name, "gauge", help);
+    HTTP_stream_printf(stream, METRICS_PREFIX "%s %" PRIu64 "\n", name, value);
+}
+
+static void metrics_counter(http_stream_t * stream, const char * name, const char * help, uint64_t value)
+{
+    metrics_family(stream, name, "counter", help);
+    HTTP_stream_printf(stream, METRICS_PREFIX "%s_total %" PRIu64 "\n", name, value);
+}
+
+// Label values are free text (pool reject messages), escape \, " and newlines
+static void metrics_label_value(http_stream_t * stream, const char * value)
+{
+    const char * start = value;
+    for (; *value; value++) {
+        const char * escaped = *value == '\\' ? "\\\\" : *value == '"' ? "\\\"" : *value == '\n' ? "\\n" : NULL;
+        if (escaped) {
+            HTTP_stream_write(stream, start, value - start);
+            HTTP_stream_write(stream, escaped, 2);
+            start = value + 1;
+        }
+    }
+    HTTP_stream_write(stream, start, value - start);
+}
+
+static esp_err_t GET_metrics(httpd_req_t * req)
+{
+    if (is_network_allowed(req) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_401_UNAUTHORIZED, "Unauthorized");
+    }
+
+    httpd_resp_set_type(req, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+
+    SystemModule * sys_module = &GLOBAL_STATE->SYSTEM_MODULE;
+    PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
+    HashrateMonitorModule * hashrate_monitor = &GLOBAL_STATE->HASHRATE_MONITOR_MODULE;
+
+    // Values are read straight from the global state, nothing is queried from I2C here
+    http_stream_t stream;
+    HTTP_stream_init(&stream, req);
+
+    metrics_family(&stream, "build", "info", "Firmware and ASIC model");
+    HTTP_stream_printf(&stream, METRICS_PREFIX "build_info{version=\"%s\",asic=\"%s\",board=\"%s\"} 1\n",
+                       esp_app_get_description()->version, GLOBAL_STATE->DEVICE_CONFIG.family.asic.name,
+                       GLOBAL_STATE->DEVICE_CONFIG.board_version);
+
+    metrics_gauge_u64(&stream, "uptime_seconds", "Time since boot", (esp_timer_get_time() - sys_module->start_time) / 1000000);
+
+    metrics_family(&stream, "hashrate_ghs", "gauge", "Hashrate in GH/s averaged over the window");
+    metrics_sample(&stream, "hashrate_ghs{window=\"current\"}", sys_module->current_hashrate);
+    metrics_sample(&stream, "hashrate_ghs{window=\"1m\"}", sys_module->hashrate_1m);
+    metrics_sample(&stream, "hashrate_ghs{window=\"10m\"}", sys_module->hashrate_10m);
+    metrics_sample(&stream, "hashrate_ghs{window=\"1h\"}", sys_module->hashrate_1h);
+
+    metrics_gauge(&stream, "expected_hashrate_ghs", "Hashrate expected from frequency and core count", power_management->expected_hashrate);
+    metrics_gauge(&stream, "error_percentage", "Share of hashes reported as errors by the ASICs", sys_module->error_percentage);
+
+    if (hashrate_monitor->is_initialized) {
+        int asic_count = GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+        int hash_domains = GLOBAL_STATE->DEVICE_CONFIG.family.asic.hash_domains;
+
+        metrics_family(&stream, "asic_hashrate_ghs", "gauge", "Hashrate counted by each ASIC");
+        for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+            HTTP_stream_printf(&stream, METRICS_PREFIX "asic_hashrate_ghs{asic=\"%d\"}", asic_nr);
+            metrics_value(&stream, hashrate_monitor->total_measurement[asic_nr].hashrate);
+        }
+
+        metrics_family(&stream, "asic_domain_hashrate_ghs", "gauge", "Hashrate counted by each hash domain of an ASIC");
+        for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+            for (int domain_nr = 0; domain_nr < hash_domains; domain_nr++) {
+                HTTP_stream_printf(&stream, METRICS_PREFIX "asic_domain_hashrate_ghs{asic=\"%d\",domain=\"%d\"}", asic_nr, domain_nr);
+                metrics_value(&stream, hashrate_monitor->domain_measurements[asic_nr][domain_nr].hashrate);
+            }
+        }
+
+        metrics_family(&stream, "asic_error_hashrate_ghs", "gauge", "Hashes per second reported as errors by each ASIC, in GH/s");
+        for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+            HTTP_stream_printf(&stream, METRICS_PREFIX "asic_error_hashrate_ghs{asic=\"%d\"}", asic_nr);
+            metrics_value(&stream, hashrate_monitor->error_measurement[asic_nr].hashrate);
+        }
+
+        metrics_family(&stream, "asic_frequency_mhz", "gauge", "Frequency of each ASIC, below the board frequency when trimmed");
+        for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+            HTTP_stream_printf(&stream, METRICS_PREFIX "asic_frequency_mhz{asic=\"%d\"}", asic_nr);
+            metrics_value(&stream, ChipFrequency_get(GLOBAL_STATE, asic_nr));
+        }
+    }
+
+    metrics_family(&stream, "temperature_celsius", "gauge", "Temperature per sensor");
+    metrics_sample(&stream, "temperature_celsius{sensor=\"asic\"}", power_management->chip_temp_avg);
+    if (power_management->chip_temp2_avg > 0) {
+        metrics_sample(&stream, "temperature_celsius{sensor=\"asic2\"}", power_management->chip_temp2_avg);
+    }
+    metrics_sample(&stream, "temperature_celsius{sensor=\"vr\"}", power_management->vr_temp);
+
+    metrics_gauge(&stream, "power_watts", "Input power", power_management->power);
+    metrics_gauge(&stream, "input_voltage_volts", "Input voltage", power_management->voltage / 1000.0f);
+    metrics_gauge(&stream, "input_current_amperes", "Input current", power_management->current / 1000.0f);
+    metrics_gauge(&stream, "frequency_mhz", "ASIC frequency", power_management->frequency_value);
+    metrics_gauge(&stream, "fan_speed_percent", "Fan duty cycle", power_management->fan_perc);
+    metrics_gauge(&stream, "fan_rpm", "Fan speed", power_management->fan_rpm);
+
+    metrics_counter(&stream, "shares_accepted", "Shares accepted by the pool", sys_module->shares_accepted);
+    metrics_counter(&stream, "shares_rejected", "Shares rejected by the pool", sys_module->shares_rejected);
+
+    metrics_family(&stream, "shares_rejected_reason", "counter", "Shares rejected by the pool per reject message");
+    for (int i = 0; i < sys_module->rejected_reason_stats_count; i++) {
+        HTTP_stream_printf(&stream, METRICS_PREFIX "shares_rejected_reason_total{reason=\"");
+        metrics_label_value(&stream, sys_module->rejected_reason_stats[i].message);
+        HTTP_stream_printf(&stream, "\"} %" PRIu32 "\n", sys_module->rejected_reason_stats[i].count);
+    }
+
+    metrics_gauge_u64(&stream, "best_difficulty", "Best share difficulty since the last reset", sys_module->best_nonce_diff);
+    metrics_gauge_u64(&stream, "best_session_difficulty", "Best share difficulty since boot", sys_module->best_session_nonce_diff);
+    metrics_gauge_u64(&stream, "pool_difficulty", "Current pool difficulty", GLOBAL_STATE->pool_difficulty);
+    metrics_gauge(&stream, "stratum_response_seconds", "Latest stratum request round trip time", sys_module->response_time / 1000.0);
+    metrics_gauge(&stream, "stratum_using_fallback", "1 when mining on the fallback pool", sys_module->is_using_fallback);
+    metrics_gauge(&stream, "free_heap_bytes", "Free heap", esp_get_free_heap_size());
+
+    HTTP_stream_write(&stream, "# EOF\n", 6);
+
+    return HTTP_stream_end(&stream);
 }
 
 esp_err_t POST_WWW_update(httpd_req_t * req)
@@ -1259,7 +1622,7 @@ esp_err_t start_rest_server(void * pvParameters)
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.stack_size = 8192;
     config.max_open_sockets = 20;
-    config.max_uri_handlers = 20;
+    config.max_uri_handlers = 24;
     config.close_fn = websocket_close_fn;
     config.lru_purge_enable = true;
 
@@ -1295,6 +1658,24 @@ esp_err_t start_rest_server(void * pvParameters)
     };
     httpd_register_uri_handler(server, &system_asic_get_uri);
 
+    /* URI handler for fetching per core nonce counts */
+    httpd_uri_t system_asic_cores_get_uri = {
+        .uri = "/api/system/asic/cores", 
+        .method = HTTP_GET, 
+        .handler = GET_system_asic_cores, 
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &system_asic_cores_get_uri);
+
+    /* URI handler for OpenMetrics scraping */
+    httpd_uri_t metrics_get_uri = {
+        .uri = "/metrics", 
+        .method = HTTP_GET, 
+        .handler = GET_metrics, 
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &metrics_get_uri);
+
     /* URI handler for fetching system statistic values */
     httpd_uri_t system_statistics_get_uri = {
         .uri = "/api/system/statistics", 
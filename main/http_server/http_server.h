@@ -5,8 +5,27 @@
 
 #include "cJSON.h"
 
+#define HTTP_STREAM_BUFFER_SIZE 1024
+
+// Chunked response writer, buffers small writes into HTTP_STREAM_BUFFER_SIZE chunks
+typedef struct
+{
+    httpd_req_t * req;
+    char buffer[HTTP_STREAM_BUFFER_SIZE];
+    size_t len;
+    esp_err_t err;
+} http_stream_t;
+
 esp_err_t is_network_allowed(httpd_req_t * req);
 esp_err_t start_rest_server(void *pvParameters);
 esp_err_t HTTP_send_json(httpd_req_t * req, const cJSON * item, int * prebuffer_len);
 
+void HTTP_stream_init(http_stream_t * stream, httpd_req_t * req);
+void HTTP_stream_write(http_stream_t * stream, const char * data, size_t len);
+void HTTP_stream_printf(http_stream_t * stream, const char * format, ...) __attribute__((format(printf, 2, 3)));
+// Writes a JSON number the way cJSON_CreateFloat() would print it
+void HTTP_stream_float(http_stream_t * stream, float number);
+// Flushes the buffer and terminates the chunked response
+esp_err_t HTTP_stream_end(http_stream_t * stream);
+
 #endif /* HTTP_SERVER_H_ */
@@ -3,9 +3,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
@@ -14,47 +16,123 @@
 
 static const char * TAG = "websocket";
 
-static QueueHandle_t log_queue = NULL;
+// Log records are appended to the active batch and the websocket task sends
+// the other one, so logging never allocates or waits on the network.
+//
+// Record layout (little endian):
+//   u8 level, u32 timestamp ms, u8 tag length, tag, u16 message length, message
+static uint8_t * log_batches[2] = {NULL, NULL};
+static size_t log_batch_len[2] = {0, 0};
+static int active_batch = 0;
+// Also counted without log_mutex, by lines that found it taken
+static uint32_t dropped_logs = 0;
+static char log_line[LOG_LINE_SIZE];
+static SemaphoreHandle_t log_mutex = NULL;
+
 static int clients[MAX_WEBSOCKET_CLIENTS];
 static int active_clients = 0;
 static SemaphoreHandle_t clients_mutex = NULL;
 
+static uint8_t log_level_from_char(char level)
+{
+    switch (level) {
+        case 'E': return WS_LOG_LEVEL_ERROR;
+        case 'W': return WS_LOG_LEVEL_WARN;
+        case 'I': return WS_LOG_LEVEL_INFO;
+        case 'D': return WS_LOG_LEVEL_DEBUG;
+        case 'V': return WS_LOG_LEVEL_VERBOSE;
+        default: return WS_LOG_LEVEL_RAW;
+    }
+}
+
+static void append_log_record(uint8_t level, uint32_t timestamp, const char * tag, size_t tag_len, const char * message, size_t message_len)
+{
+    if (tag_len > UINT8_MAX) tag_len = UINT8_MAX;
+
+    uint8_t * batch = log_batches[active_batch];
+    size_t len = log_batch_len[active_batch];
+    if (batch == NULL || len + 8 + tag_len + message_len > LOG_BATCH_SIZE) {
+        __atomic_fetch_add(&dropped_logs, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    batch[len++] = level;
+    memcpy(&batch[len], &timestamp, sizeof(timestamp));
+    len += sizeof(timestamp);
+    batch[len++] = tag_len;
+    memcpy(&batch[len], tag, tag_len);
+    len += tag_len;
+    uint16_t message_len16 = message_len;
+    memcpy(&batch[len], &message_len16, sizeof(message_len16));
+    len += sizeof(message_len16);
+    memcpy(&batch[len], message, message_len);
+    len += message_len;
+
+    log_batch_len[active_batch] = len;
+}
+
+// Splits "\033[0;32mI (1234) tag: message\033[0m\n" into its fields; anything
+// else is kept as a raw message
+static void encode_log_line(const char * line, size_t len)
+{
+    const char * end = line + len;
+    while (end > line && (end[-1] == '\n' || end[-1] == '\r')) end--;
+    if (end - line >= 4 && memcmp(end - 4, "\033[0m", 4) == 0) end -= 4;
+
+    const char * p = line;
+    if (p < end && *p == '\033') {
+        while (p < end && *p != 'm') p++;
+        if (p < end) p++;
+    }
+
+    uint8_t level = p < end ? log_level_from_char(*p) : WS_LOG_LEVEL_RAW;
+    if (level != WS_LOG_LEVEL_RAW && end - p > 4 && p[1] == ' ' && p[2] == '(') {
+        char * timestamp_end;
+        uint32_t timestamp = strtoul(p + 3, &timestamp_end, 10);
+        const char * tag = timestamp_end + 2;
+        if (timestamp_end > p + 3 && tag <= end && timestamp_end[0] == ')' && timestamp_end[1] == ' ') {
+            const char * tag_end = tag;
+            while (tag_end + 1 < end && !(tag_end[0] == ':' && tag_end[1] == ' ')) tag_end++;
+            if (tag_end + 1 < end) {
+                const char * message = tag_end + 2;
+                append_log_record(level, timestamp, tag, tag_end - tag, message, end - message);
+                return;
+            }
+        }
+    }
+
+    append_log_record(WS_LOG_LEVEL_RAW, 0, NULL, 0, line, end - line);
+}
+
 int log_to_queue(const char *format, va_list args)
 {
     va_list args_copy;
-    va_copy(args_copy, args);
 
-    // Calculate the required buffer size +1 for \n
-    int needed_size = vsnprintf(NULL, 0, format, args_copy) + 1;
+    // The serial write can block for milliseconds, it is done without the lock
+    va_copy(args_copy, args);
+    vprintf(format, args_copy);
     va_end(args_copy);
 
-    // Allocate the buffer dynamically
-    char *log_buffer = (char *)calloc(needed_size, sizeof(char));
-    if (log_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for log buffer");
+    if (log_mutex == NULL || !websocket_has_clients()) {
+        return 0;
+    }
+
+    // The lock only covers formatting into the batch, a line waits at most for
+    // one other line and otherwise misses the websocket
+    if (xSemaphoreTake(log_mutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        __atomic_fetch_add(&dropped_logs, 1, __ATOMIC_RELAXED);
         return 0;
     }
 
-    // Format the string into the allocated buffer
     va_copy(args_copy, args);
-    vsnprintf(log_buffer, needed_size, format, args_copy);
+    int len = vsnprintf(log_line, sizeof(log_line), format, args_copy);
     va_end(args_copy);
 
-    // Ensure the log message ends with a newline
-    size_t len = strlen(log_buffer);
-    if (len > 0 && log_buffer[len - 1] != '\n') {
-        log_buffer[len] = '\n';
-        log_buffer[len + 1] = '\0';
+    if (len > 0) {
+        encode_log_line(log_line, len < sizeof(log_line) ? len : sizeof(log_line) - 1);
     }
 
-    // Print to standard output
-    fputs(log_buffer, stdout);
-
-    // Send to queue for WebSocket broadcasting
-    if (xQueueSendToBack(log_queue, &log_buffer, pdMS_TO_TICKS(100)) != pdPASS) {
-        ESP_LOGW(TAG, "Failed to send log to queue, freeing buffer");
-        free(log_buffer);
-    }
+    xSemaphoreGive(log_mutex);
 
     return 0;
 }
@@ -70,6 +148,11 @@ static esp_err_t add_client(int fd)
     for (int i = 0; i < MAX_WEBSOCKET_CLIENTS; i++) {
         if (clients[i] == -1) {
             if (active_clients == 0) {
+                if (log_mutex != NULL && xSemaphoreTake(log_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+                    log_batch_len[0] = log_batch_len[1] = 0;
+                    __atomic_store_n(&dropped_logs, 0, __ATOMIC_RELAXED);
+                    xSemaphoreGive(log_mutex);
+                }
                 esp_log_set_vprintf(log_to_queue);
             }
 
@@ -88,6 +171,11 @@ static esp_err_t add_client(int fd)
     return ret;
 }
 
+bool websocket_has_clients(void)
+{
+    return __atomic_load_n(&active_clients, __ATOMIC_RELAXED) > 0;
+}
+
 static void remove_client(int fd)
 {
     if (xSemaphoreTake(clients_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
@@ -195,14 +283,34 @@ esp_err_t websocket_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static void send_log_batch(httpd_handle_t https_handle, uint8_t * batch, size_t len)
+{
+    for (int i = 0; i < MAX_WEBSOCKET_CLIENTS; i++) {
+        int client_fd = clients[i];
+        if (client_fd != -1) {
+            httpd_ws_frame_t ws_pkt;
+            memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
+            ws_pkt.payload = batch;
+            ws_pkt.len = len;
+            ws_pkt.type = HTTPD_WS_TYPE_BINARY;
+
+            if (httpd_ws_send_frame_async(https_handle, client_fd, &ws_pkt) != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to send WebSocket frame to fd: %d", client_fd);
+                remove_client(client_fd);
+            }
+        }
+    }
+}
+
 void websocket_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "websocket_task starting");
     httpd_handle_t https_handle = (httpd_handle_t)pvParameters;
 
-    log_queue = xQueueCreateWithCaps(MESSAGE_QUEUE_SIZE, sizeof(char*), MALLOC_CAP_SPIRAM);
-    if (log_queue == NULL) {
-        ESP_LOGE(TAG, "Error creating queue");
+    log_batches[0] = heap_caps_malloc(LOG_BATCH_SIZE, MALLOC_CAP_SPIRAM);
+    log_batches[1] = heap_caps_malloc(LOG_BATCH_SIZE, MALLOC_CAP_SPIRAM);
+    if (log_batches[0] == NULL || log_batches[1] == NULL) {
+        ESP_LOGE(TAG, "Error allocating log batches");
         vTaskDelete(NULL);
         return;
     }
@@ -214,33 +322,34 @@ void websocket_task(void *pvParameters)
         ESP_LOGE(TAG, "Failed to create clients mutex");
     }
 
+    log_mutex = xSemaphoreCreateMutex();
+    if (log_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create log mutex");
+    }
+
     while (true) {
-        if (active_clients == 0) {
-            vTaskDelay(pdMS_TO_TICKS(100));
+        vTaskDelay(pdMS_TO_TICKS(active_clients == 0 ? 100 : LOG_FLUSH_MS));
+
+        if (active_clients == 0 || log_mutex == NULL) {
             continue;
         }
 
-        char *message;
-        if (xQueueReceive(log_queue, &message, pdMS_TO_TICKS(1000)) != pdPASS) {
+        if (xSemaphoreTake(log_mutex, portMAX_DELAY) != pdTRUE) {
             continue;
         }
-
-        for (int i = 0; i < MAX_WEBSOCKET_CLIENTS; i++) {
-            int client_fd = clients[i];
-            if (client_fd != -1) {
-                httpd_ws_frame_t ws_pkt;
-                memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-                ws_pkt.payload = (uint8_t *)message;
-                ws_pkt.len = strlen(message);
-                ws_pkt.type = HTTPD_WS_TYPE_TEXT;
-
-                if (httpd_ws_send_frame_async(https_handle, client_fd, &ws_pkt) != ESP_OK) {
-                    ESP_LOGW(TAG, "Failed to send WebSocket frame to fd: %d", client_fd);
-                    remove_client(client_fd);
-                }
-            }
+        int batch = active_batch;
+        size_t len = log_batch_len[batch];
+        active_batch = !batch;
+        log_batch_len[active_batch] = 0;
+        xSemaphoreGive(log_mutex);
+        uint32_t dropped = __atomic_exchange_n(&dropped_logs, 0, __ATOMIC_RELAXED);
+
+        if (len > 0) {
+            send_log_batch(https_handle, log_batches[batch], len);
         }
 
-        free(message);
+        if (dropped > 0) {
+            ESP_LOGW(TAG, "Log batch full or busy, %" PRIu32 " lines not sent", dropped);
+        }
     }
 }
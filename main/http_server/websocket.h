@@ -2,12 +2,26 @@
 #define WEBSOCKET_H_
 
 #include "esp_err.h"
+#include "esp_http_server.h"
 
-#define MESSAGE_QUEUE_SIZE (128)
+#define LOG_BATCH_SIZE (8192)
+#define LOG_LINE_SIZE (512)
+#define LOG_FLUSH_MS (200)
 #define MAX_WEBSOCKET_CLIENTS (10)
 
+// Level byte of the binary log records
+#define WS_LOG_LEVEL_RAW 0
+#define WS_LOG_LEVEL_ERROR 1
+#define WS_LOG_LEVEL_WARN 2
+#define WS_LOG_LEVEL_INFO 3
+#define WS_LOG_LEVEL_DEBUG 4
+#define WS_LOG_LEVEL_VERBOSE 5
+
 esp_err_t websocket_handler(httpd_req_t * req);
 void websocket_task(void * pvParameters);
 void websocket_close_fn(httpd_handle_t hd, int sockfd);
 
+// True while a client receives the log, so costly log lines can be skipped otherwise
+bool websocket_has_clients(void);
+
 #endif /* WEBSOCKET_H_ */
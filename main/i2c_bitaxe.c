@@ -12,10 +12,11 @@
 #define I2C_MASTER_FREQ_HZ 100000   /*!< I2C master clock frequency */
 
 #define I2C_MASTER_NUM 0            /*!< I2C master i2c port number, the number of i2c peripheral interfaces available will depend on the chip */
-#define I2C_MASTER_TIMEOUT_MS 1000
+// A device that holds the bus fails the transfer instead of blocking its caller
+// for good; well above the 35 ms SMBus clock low timeout
+#define I2C_MASTER_TIMEOUT_MS 100
 
-//#define I2C_DEFAULT_TIMEOUT ( I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS )
-#define I2C_DEFAULT_TIMEOUT -1  //-1 means wait forever
+#define I2C_DEFAULT_TIMEOUT I2C_MASTER_TIMEOUT_MS // ms
 
 static i2c_master_bus_handle_t i2c_bus_handle;
 
@@ -7,6 +7,8 @@
 #include "create_jobs_task.h"
 #include "hashrate_monitor_task.h"
 #include "statistics_task.h"
+#include "sensor_task.h"
+#include "nonce_trace_task.h"
 #include "system.h"
 #include "http_server.h"
 #include "serial.h"
@@ -71,6 +73,10 @@ void app_main(void)
 
     SYSTEM_init_peripherals(&GLOBAL_STATE);
 
+    if (xTaskCreate(SENSOR_task, "sensors", 4096, (void *) &GLOBAL_STATE, 10, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating sensor task");
+    }
+
     if (xTaskCreate(POWER_MANAGEMENT_task, "power management", 8192, (void *) &GLOBAL_STATE, 10, NULL) != pdPASS) {
         ESP_LOGE(TAG, "Error creating power management task");
     }
@@ -111,6 +117,9 @@ void app_main(void)
     if (xTaskCreateWithCaps(hashrate_monitor_task, "hashrate monitor", 8192, (void *) &GLOBAL_STATE, 5, NULL, MALLOC_CAP_SPIRAM) != pdPASS) {
         ESP_LOGE(TAG, "Error creating hashrate monitor task");
     }
+    if (xTaskCreateWithCaps(nonce_trace_task, "nonce trace", 4096, NULL, 1, NULL, MALLOC_CAP_SPIRAM) != pdPASS) {
+        ESP_LOGE(TAG, "Error creating nonce trace task");
+    }
     if (xTaskCreateWithCaps(statistics_task, "statistics", 8192, (void *) &GLOBAL_STATE, 3, NULL, MALLOC_CAP_SPIRAM) != pdPASS) {
         ESP_LOGE(TAG, "Error creating statistics task");
     }
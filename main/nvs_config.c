@@ -65,10 +65,19 @@ static Settings settings[NVS_CONFIG_COUNT] = {
     [NVS_CONFIG_FALLBACK_STRATUM_TLS]                  = {.nvs_key_name = "fbstratumtls",    .type = TYPE_U16,   .default_value = {.u16 = (uint16_t)CONFIG_FALLBACK_STRATUM_TLS},       .rest_name = "fallbackStratumTLS",                 .min = 0,  .max = 3},
     [NVS_CONFIG_FALLBACK_STRATUM_CERT]                 = {.nvs_key_name = "fbstratumcert",   .type = TYPE_STR,   .default_value = {.str = (char *)CONFIG_FALLBACK_STRATUM_CERT},        .rest_name = "fallbackStratumCert",                .min = 0,  .max = NVS_STR_LIMIT},
     [NVS_CONFIG_USE_FALLBACK_STRATUM]                  = {.nvs_key_name = "usefbstartum",    .type = TYPE_BOOL,                                                                         .rest_name = "useFallbackStratum",                 .min = 0,  .max = 1},
+    [NVS_CONFIG_NTIME_ROLL_WINDOW]                     = {.nvs_key_name = "ntimerollwin",    .type = TYPE_U16,                                                                          .rest_name = "ntimeRollWindow",                    .min = 0,  .max = 600},
 
     [NVS_CONFIG_ASIC_FREQUENCY]                        = {.nvs_key_name = "asicfrequency_f", .type = TYPE_FLOAT, .default_value = {.f   = CONFIG_ASIC_FREQUENCY},                       .rest_name = "frequency",                          .min = 1,  .max = UINT16_MAX},
     [NVS_CONFIG_ASIC_VOLTAGE]                          = {.nvs_key_name = "asicvoltage",     .type = TYPE_U16,   .default_value = {.u16 = CONFIG_ASIC_VOLTAGE},                         .rest_name = "coreVoltage",                        .min = 1,  .max = UINT16_MAX},
     [NVS_CONFIG_OVERCLOCK_ENABLED]                     = {.nvs_key_name = "oc_enabled",      .type = TYPE_BOOL,                                                                         .rest_name = "overclockEnabled",                   .min = 0,  .max = 1},
+    [NVS_CONFIG_NONCE_RANGE_MODE]                      = {.nvs_key_name = "noncerange",      .type = TYPE_U16,                                                                          .rest_name = "nonceRangeMode",                     .min = 0,  .max = 1},
+    [NVS_CONFIG_AUTOTUNE_MODE]                         = {.nvs_key_name = "autotunemode",    .type = TYPE_U16,                                                                          .rest_name = "autotuneMode",                       .min = 0,  .max = 2},
+    [NVS_CONFIG_AUTOTUNE_POWER_LIMIT]                  = {.nvs_key_name = "autotunepower",   .type = TYPE_U16,                                                                          .rest_name = "autotunePowerLimit",                 .min = 0,  .max = UINT16_MAX},
+    [NVS_CONFIG_AUTOTUNE_TEMP_LIMIT]                   = {.nvs_key_name = "autotunetemp",    .type = TYPE_U16,   .default_value = {.u16 = 65},                                          .rest_name = "autotuneTempLimit",                  .min = 35, .max = 70},
+    [NVS_CONFIG_AUTOTUNED]                             = {.nvs_key_name = "autotuned",       .type = TYPE_BOOL},
+    [NVS_CONFIG_CHIP_FREQUENCY]                        = {.nvs_key_name = "chipfrequency",   .type = TYPE_BOOL,                                                                         .rest_name = "perChipFrequency",                   .min = 0,  .max = 1},
+    [NVS_CONFIG_FREQUENCY_GOVERNOR]                    = {.nvs_key_name = "freqgovernor",    .type = TYPE_BOOL,                                                                         .rest_name = "frequencyGovernor",                  .min = 0,  .max = 1},
+    [NVS_CONFIG_POWER_CAP]                             = {.nvs_key_name = "powercap",        .type = TYPE_U16,                                                                          .rest_name = "powerCap",                           .min = 0,  .max = UINT16_MAX},
     
     [NVS_CONFIG_DISPLAY]                               = {.nvs_key_name = "display",         .type = TYPE_STR,   .default_value = {.str = DEFAULT_DISPLAY},                             .rest_name = "display",                            .min = 0,  .max = NVS_STR_LIMIT},
     [NVS_CONFIG_ROTATION]                              = {.nvs_key_name = "rotation",        .type = TYPE_U16,                                                                          .rest_name = "rotation",                           .min = 0,  .max = 270},
@@ -80,9 +89,11 @@ static Settings settings[NVS_CONFIG_COUNT] = {
     [NVS_CONFIG_MANUAL_FAN_SPEED]                      = {.nvs_key_name = "manualfanspeed",  .type = TYPE_U16,   .default_value = {.u16 = 100},                                         .rest_name = "manualFanSpeed",                     .min = 0,  .max = 100},
     [NVS_CONFIG_MIN_FAN_SPEED]                         = {.nvs_key_name = "minfanspeed",     .type = TYPE_U16,   .default_value = {.u16 = 25},                                          .rest_name = "minFanSpeed",                        .min = 0,  .max = 99},
     [NVS_CONFIG_TEMP_TARGET]                           = {.nvs_key_name = "temptarget",      .type = TYPE_U16,   .default_value = {.u16 = 60},                                          .rest_name = "temptarget",                         .min = 35, .max = 66},
+    [NVS_CONFIG_FAN_FEED_FORWARD]                      = {.nvs_key_name = "fanfeedfwd",      .type = TYPE_BOOL,                                                                         .rest_name = "fanFeedForward",                     .min = 0,  .max = 1},
     [NVS_CONFIG_OVERHEAT_MODE]                         = {.nvs_key_name = "overheat_mode",   .type = TYPE_BOOL,                                                                         .rest_name = "overheat_mode",                      .min = 0,  .max = 0},
 
     [NVS_CONFIG_STATISTICS_FREQUENCY]                  = {.nvs_key_name = "statsFrequency",  .type = TYPE_U16,                                                                          .rest_name = "statsFrequency",                     .min = 0,  .max = UINT16_MAX},
+    [NVS_CONFIG_STATISTICS_HASHRATE_DETAIL]            = {.nvs_key_name = "statsdetail",     .type = TYPE_BOOL,                                                                         .rest_name = "statsHashrateDetail",                .min = 0,  .max = 1},
 
     [NVS_CONFIG_BEST_DIFF]                             = {.nvs_key_name = "bestdiff",        .type = TYPE_U64},
     [NVS_CONFIG_SELF_TEST]                             = {.nvs_key_name = "selftest",        .type = TYPE_BOOL},
@@ -27,10 +27,19 @@ typedef enum {
     NVS_CONFIG_FALLBACK_STRATUM_TLS,
     NVS_CONFIG_FALLBACK_STRATUM_CERT,
     NVS_CONFIG_USE_FALLBACK_STRATUM,
+    NVS_CONFIG_NTIME_ROLL_WINDOW,
     
     NVS_CONFIG_ASIC_FREQUENCY,
     NVS_CONFIG_ASIC_VOLTAGE,
     NVS_CONFIG_OVERCLOCK_ENABLED,
+    NVS_CONFIG_NONCE_RANGE_MODE,
+    NVS_CONFIG_AUTOTUNE_MODE,
+    NVS_CONFIG_AUTOTUNE_POWER_LIMIT,
+    NVS_CONFIG_AUTOTUNE_TEMP_LIMIT,
+    NVS_CONFIG_AUTOTUNED,
+    NVS_CONFIG_CHIP_FREQUENCY,
+    NVS_CONFIG_FREQUENCY_GOVERNOR,
+    NVS_CONFIG_POWER_CAP,
     
     NVS_CONFIG_DISPLAY,
     NVS_CONFIG_ROTATION,
@@ -42,9 +51,11 @@ typedef enum {
     NVS_CONFIG_MANUAL_FAN_SPEED,
     NVS_CONFIG_MIN_FAN_SPEED,
     NVS_CONFIG_TEMP_TARGET,
+    NVS_CONFIG_FAN_FEED_FORWARD,
     NVS_CONFIG_OVERHEAT_MODE,
     
     NVS_CONFIG_STATISTICS_FREQUENCY,
+    NVS_CONFIG_STATISTICS_HASHRATE_DETAIL,
     
     NVS_CONFIG_BEST_DIFF,
     NVS_CONFIG_SELF_TEST,
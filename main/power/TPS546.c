@@ -5,6 +5,7 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 
 #include "pmbus_commands.h"
 
@@ -35,6 +36,12 @@ static i2c_master_dev_handle_t tps546_i2c_handle;
 
 static TPS546_CONFIG tps546_config;
 
+// Last burst of TPS546_read_telemetry, timestamp 0 until the first one
+static TPS546_TELEMETRY telemetry;
+
+// TPS546_check_status takes the status from a burst at most this old
+#define TELEMETRY_MAX_AGE_MS 2000
+
 static esp_err_t TPS546_parse_status(uint16_t);
 
 /**
@@ -746,12 +753,55 @@ float TPS546_get_vout(void)
     }
 }
 
+/**
+ * @brief Reads all monitored values in one burst and keeps them for TPS546_check_status.
+ * STATUS_WORD is only read when STATUS_BYTE, its low byte, changed or flags the high byte.
+ * @param result Filled with the decoded values
+ */
+esp_err_t TPS546_read_telemetry(TPS546_TELEMETRY * result)
+{
+    uint16_t vin, vout, iout, temperature;
+    uint8_t status_byte;
+
+    // PHASE stays at 0xFF from the configuration, so READ_IOUT covers all phases
+    ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_READ_VIN, &vin), TAG, "Could not read VIN");
+    ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_READ_VOUT, &vout), TAG, "Could not read Vout");
+    ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_READ_IOUT, &iout), TAG, "Could not read Iout");
+    ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_READ_TEMPERATURE_1, &temperature), TAG, "Could not read temperature");
+    ESP_RETURN_ON_ERROR(smb_read_byte(PMBUS_STATUS_BYTE, &status_byte), TAG, "Could not read STATUS_BYTE");
+
+    uint16_t status = telemetry.status;
+    if (telemetry.timestamp == 0 || status_byte != (status & 0xFF) || (status_byte & TPS546_STATUS_NONE)) {
+        ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_STATUS_WORD, &status), TAG, "Could not read STATUS_WORD");
+    }
+
+    telemetry.vin = slinear11_2_float(vin);
+    telemetry.vout = ulinear16_2_float(vout);
+    telemetry.iout = slinear11_2_float(iout);
+    telemetry.temperature = slinear11_2_float(temperature);
+    telemetry.status = status;
+    telemetry.timestamp = esp_timer_get_time() / 1000;
+
+#ifdef DEBUG_TPS546_MEAS
+    ESP_LOGI(TAG, "Vin: %2.3f V, Vout: %2.3f V, Iout: %2.3f A, Temp: %.1f C, Status: %04x",
+             telemetry.vin, telemetry.vout, telemetry.iout, telemetry.temperature, telemetry.status);
+#endif
+
+    *result = telemetry;
+    return ESP_OK;
+}
+
 esp_err_t TPS546_check_status(GlobalState * GLOBAL_STATE) {
 
     SystemModule * SYSTEM_MODULE = &GLOBAL_STATE->SYSTEM_MODULE;
     uint16_t status;
 
-    ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_STATUS_WORD, &status), TAG, "Failed to read STATUS_WORD");
+    uint32_t timestamp = telemetry.timestamp;
+    if (timestamp != 0 && (uint32_t) (esp_timer_get_time() / 1000) - timestamp <= TELEMETRY_MAX_AGE_MS) {
+        status = telemetry.status;
+    } else {
+        ESP_RETURN_ON_ERROR(smb_read_word(PMBUS_STATUS_WORD, &status), TAG, "Failed to read STATUS_WORD");
+    }
     //determine if this is a fault we care about
     if (status & (TPS546_STATUS_OFF | TPS546_STATUS_VOUT_OV | TPS546_STATUS_IOUT_OC | TPS546_STATUS_VIN_UV | TPS546_STATUS_TEMP)) {
         if (SYSTEM_MODULE->power_fault == 0) {
@@ -167,6 +167,16 @@ typedef struct
 #define TPS546_STATUS_MFR_BCX     0x04 //bit 2 - A BCX fault event has occurred.
 #define TPS546_STATUS_MFR_SYNC    0x02 //bit 1 - A SYNC fault has been detected.
 
+/* telemetry read in one burst by TPS546_read_telemetry */
+typedef struct
+{
+  uint32_t timestamp; /* ms since boot */
+  float vin;          /* V */
+  float vout;         /* V */
+  float iout;         /* A, all phases */
+  float temperature;  /* °C */
+  uint16_t status;    /* STATUS_WORD */
+} TPS546_TELEMETRY;
 
 /* public functions */
 esp_err_t TPS546_init(TPS546_CONFIG config);
@@ -179,6 +189,7 @@ int TPS546_get_temperature(void);
 float TPS546_get_vin(void);
 float TPS546_get_iout(void);
 float TPS546_get_vout(void);
+esp_err_t TPS546_read_telemetry(TPS546_TELEMETRY * telemetry);
 esp_err_t TPS546_set_vout(float volts);
 void TPS546_show_voltage_settings(void);
 void TPS546_print_status(void);
@@ -0,0 +1,236 @@
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "global_state.h"
+#include "nvs_config.h"
+#include "autotune.h"
+
+#define AUTOTUNE_FREQUENCY_STEP 25.0f
+#define AUTOTUNE_OVERCLOCK_HEADROOM 100.0f // MHz above the highest option when overclocking is enabled
+#define AUTOTUNE_SETTLE_MS (60 * 1000)
+#define AUTOTUNE_MEASURE_MS (2 * 60 * 1000)
+#define AUTOTUNE_MAX_ERROR_PERCENTAGE 1.0f
+
+static const char * TAG = "autotune";
+
+static uint32_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static float power_limit(GlobalState * GLOBAL_STATE)
+{
+    uint16_t limit = nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_POWER_LIMIT);
+    return limit > 0 ? limit : GLOBAL_STATE->DEVICE_CONFIG.family.max_power;
+}
+
+// J/TH, power is W and hashrate GH/s
+static float efficiency(const AutotunePoint * point)
+{
+    return point->power / (point->hashrate / 1000.0f);
+}
+
+static bool is_better(AutotuneMode mode, const AutotunePoint * point, const AutotunePoint * best)
+{
+    if (best->hashrate <= 0) return true;
+    if (mode == AUTOTUNE_MODE_EFFICIENCY) return efficiency(point) < efficiency(best);
+    return point->hashrate > best->hashrate;
+}
+
+static void enter_state(AutotuneModule * autotune, AutotuneState state)
+{
+    autotune->state = state;
+    autotune->state_start_ms = now_ms();
+    autotune->samples = 0;
+    autotune->hashrate_sum = 0;
+    autotune->power_sum = 0;
+    autotune->error_sum = 0;
+    autotune->temperature_max = 0;
+}
+
+static void finish(AutotuneModule * autotune)
+{
+    if (autotune->best.hashrate <= 0) {
+        ESP_LOGW(TAG, "No stable point found after %u points, keeping the current settings", autotune->points_tested);
+        enter_state(autotune, AUTOTUNE_FAILED);
+        return;
+    }
+
+    // Step down to the chosen frequency before the voltage is lowered
+    autotune->frequency = autotune->best.frequency;
+    enter_state(autotune, AUTOTUNE_APPLYING);
+}
+
+static void next_point(GlobalState * GLOBAL_STATE, bool stable)
+{
+    AutotuneModule * autotune = &GLOBAL_STATE->AUTOTUNE_MODULE;
+    const uint16_t * voltage_options = GLOBAL_STATE->DEVICE_CONFIG.family.asic.voltage_options;
+
+    if (stable) {
+        if (autotune->frequency + AUTOTUNE_FREQUENCY_STEP > autotune->max_frequency) {
+            finish(autotune);
+            return;
+        }
+        autotune->frequency += AUTOTUNE_FREQUENCY_STEP;
+    } else {
+        // Retry the same frequency one voltage step up
+        if (voltage_options[autotune->voltage_index + 1] == 0) {
+            finish(autotune);
+            return;
+        }
+        autotune->voltage_index++;
+        autotune->voltage = voltage_options[autotune->voltage_index];
+    }
+
+    ESP_LOGI(TAG, "Testing %g MHz at %u mV", autotune->frequency, autotune->voltage);
+    enter_state(autotune, AUTOTUNE_SETTLING);
+}
+
+void Autotune_start(void * pvParameters, AutotuneMode mode)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    AutotuneModule * autotune = &GLOBAL_STATE->AUTOTUNE_MODULE;
+    const AsicConfig * asic = &GLOBAL_STATE->DEVICE_CONFIG.family.asic;
+
+    if (mode == AUTOTUNE_MODE_EFFICIENCY && !GLOBAL_STATE->DEVICE_CONFIG.TPS546 && !GLOBAL_STATE->DEVICE_CONFIG.INA260) {
+        ESP_LOGW(TAG, "No power sensor, tuning for hashrate instead of efficiency");
+        mode = AUTOTUNE_MODE_HASHRATE;
+    }
+
+    autotune->mode = mode;
+    autotune->voltage_index = 0;
+    autotune->voltage = asic->voltage_options[0];
+    autotune->frequency = asic->frequency_options[0];
+    autotune->max_frequency = device_config_highest_frequency(asic);
+    if (nvs_config_get_bool(NVS_CONFIG_OVERCLOCK_ENABLED)) {
+        autotune->max_frequency += AUTOTUNE_OVERCLOCK_HEADROOM;
+    }
+    autotune->points_tested = 0;
+    autotune->best = (AutotunePoint){0};
+
+    nvs_config_set_bool(NVS_CONFIG_AUTOTUNED, false);
+
+    ESP_LOGI(TAG, "Starting %s sweep up to %g MHz, %g W, %u °C, testing %g MHz at %u mV",
+             mode == AUTOTUNE_MODE_EFFICIENCY ? "efficiency" : "hashrate", autotune->max_frequency,
+             power_limit(GLOBAL_STATE), nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_TEMP_LIMIT), autotune->frequency, autotune->voltage);
+
+    enter_state(autotune, AUTOTUNE_SETTLING);
+}
+
+void Autotune_stop(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    AutotuneModule * autotune = &GLOBAL_STATE->AUTOTUNE_MODULE;
+
+    if (Autotune_is_running(GLOBAL_STATE)) {
+        ESP_LOGW(TAG, "Sweep stopped after %u points", autotune->points_tested);
+    }
+    autotune->mode = AUTOTUNE_MODE_OFF;
+    autotune->state = AUTOTUNE_IDLE;
+}
+
+bool Autotune_is_running(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    AutotuneState state = GLOBAL_STATE->AUTOTUNE_MODULE.state;
+
+    return state == AUTOTUNE_SETTLING || state == AUTOTUNE_MEASURING || state == AUTOTUNE_APPLYING;
+}
+
+bool Autotune_update(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    AutotuneModule * autotune = &GLOBAL_STATE->AUTOTUNE_MODULE;
+    PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
+    SystemModule * sys_module = &GLOBAL_STATE->SYSTEM_MODULE;
+
+    switch (autotune->state) {
+        case AUTOTUNE_SETTLING:
+        case AUTOTUNE_MEASURING:
+            break;
+        case AUTOTUNE_APPLYING:
+            nvs_config_set_float(NVS_CONFIG_ASIC_FREQUENCY, autotune->best.frequency);
+            nvs_config_set_u16(NVS_CONFIG_ASIC_VOLTAGE, autotune->best.voltage);
+            nvs_config_set_bool(NVS_CONFIG_AUTOTUNED, true);
+            ESP_LOGI(TAG, "Tuned to %g MHz at %u mV: %.1f GH/s, %.2f W, %.2f J/TH after %u points",
+                     autotune->best.frequency, autotune->best.voltage, autotune->best.hashrate, autotune->best.power,
+                     efficiency(&autotune->best), autotune->points_tested);
+            enter_state(autotune, AUTOTUNE_DONE);
+            return false;
+        default:
+            return false;
+    }
+
+    float temperature = fmaxf(power_management->chip_temp_avg, power_management->chip_temp2_avg);
+    uint16_t temp_limit = nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_TEMP_LIMIT);
+
+    // The power cap holding the frequency below the point under test counts as crossing the power limit
+    bool capped = autotune->state == AUTOTUNE_MEASURING && power_management->frequency_value < autotune->frequency;
+
+    // Limits are checked on every update, the point is dropped as soon as one is crossed
+    if (temperature > temp_limit || power_management->power > power_limit(GLOBAL_STATE) || capped) {
+        ESP_LOGI(TAG, "%g MHz at %u mV exceeds the limits (%.1f °C, %.2f W)", autotune->frequency, autotune->voltage,
+                 temperature, power_management->power);
+        autotune->points_tested++;
+        // Higher frequency or voltage only draws more power and heat
+        finish(autotune);
+        return autotune->state != AUTOTUNE_FAILED;
+    }
+
+    uint32_t elapsed = now_ms() - autotune->state_start_ms;
+
+    if (autotune->state == AUTOTUNE_SETTLING) {
+        if (elapsed >= AUTOTUNE_SETTLE_MS) {
+            enter_state(autotune, AUTOTUNE_MEASURING);
+        }
+        return true;
+    }
+
+    autotune->samples++;
+    autotune->hashrate_sum += sys_module->current_hashrate;
+    autotune->power_sum += power_management->power;
+    autotune->error_sum += sys_module->error_percentage;
+    autotune->temperature_max = fmaxf(autotune->temperature_max, temperature);
+
+    if (elapsed < AUTOTUNE_MEASURE_MS) {
+        return true;
+    }
+
+    AutotunePoint point = {
+        .frequency = autotune->frequency,
+        .voltage = autotune->voltage,
+        .hashrate = autotune->hashrate_sum / autotune->samples,
+        .power = autotune->power_sum / autotune->samples,
+        .error_percentage = autotune->error_sum / autotune->samples,
+        .temperature = autotune->temperature_max,
+    };
+    autotune->points_tested++;
+
+    const AsicConfig * asic = &GLOBAL_STATE->DEVICE_CONFIG.family.asic;
+    float expected = point.frequency * asic->small_core_count * GLOBAL_STATE->DEVICE_CONFIG.family.asic_count / 1000.0f;
+    bool stable = point.hashrate >= expected * asic->hashrate_test_percentage_target &&
+                  point.error_percentage <= AUTOTUNE_MAX_ERROR_PERCENTAGE;
+
+    ESP_LOGI(TAG, "%g MHz at %u mV: %.1f of %.1f GH/s, %.2f%% errors, %.2f W, %.1f °C, %s", point.frequency, point.voltage,
+             point.hashrate, expected, point.error_percentage, point.power, point.temperature, stable ? "stable" : "unstable");
+
+    if (stable && is_better(autotune->mode, &point, &autotune->best)) {
+        autotune->best = point;
+    }
+
+    next_point(GLOBAL_STATE, stable);
+    return autotune->state != AUTOTUNE_FAILED;
+}
+
+const char * Autotune_state_to_string(AutotuneState state)
+{
+    switch (state) {
+        case AUTOTUNE_IDLE:      return "idle";
+        case AUTOTUNE_SETTLING:  return "settling";
+        case AUTOTUNE_MEASURING: return "measuring";
+        case AUTOTUNE_APPLYING:  return "applying";
+        case AUTOTUNE_DONE:      return "done";
+        case AUTOTUNE_FAILED:    return "failed";
+        default:                 return "unknown";
+    }
+}
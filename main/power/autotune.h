@@ -0,0 +1,70 @@
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    AUTOTUNE_MODE_OFF,
+    AUTOTUNE_MODE_HASHRATE,   // highest hashrate within the power and temperature limits
+    AUTOTUNE_MODE_EFFICIENCY, // lowest J/TH within the power and temperature limits
+} AutotuneMode;
+
+typedef enum
+{
+    AUTOTUNE_IDLE,
+    AUTOTUNE_SETTLING,
+    AUTOTUNE_MEASURING,
+    AUTOTUNE_APPLYING,
+    AUTOTUNE_DONE,
+    AUTOTUNE_FAILED,
+} AutotuneState;
+
+typedef struct
+{
+    float frequency;
+    uint16_t voltage;
+    float hashrate;         // GH/s
+    float power;            // W
+    float error_percentage;
+    float temperature;      // highest ASIC temperature seen
+} AutotunePoint;
+
+typedef struct
+{
+    AutotuneMode mode;
+    AutotuneState state;
+
+    // Point under test, applied instead of the frequency and voltage settings while tuning
+    float frequency;
+    uint16_t voltage;
+    uint8_t voltage_index;
+    float max_frequency;
+    uint16_t points_tested;
+
+    AutotunePoint best; // hashrate is 0 until a point passed
+
+    uint32_t state_start_ms;
+    uint16_t samples;
+    float hashrate_sum;
+    float power_sum;
+    float error_sum;
+    float temperature_max;
+} AutotuneModule;
+
+// Sweeps frequency/voltage pairs from the lowest option upwards: frequency is
+// raised while the chips keep up, the voltage is raised when they stop keeping
+// up, and the sweep ends at the power or temperature limit or the last option.
+// The best point is stored as the frequency and voltage settings.
+void Autotune_start(void * pvParameters, AutotuneMode mode);
+void Autotune_stop(void * pvParameters);
+bool Autotune_is_running(void * pvParameters);
+
+// Advances the sweep, called from the power management loop. Returns true while
+// the tuner owns frequency and voltage.
+bool Autotune_update(void * pvParameters);
+
+const char * Autotune_state_to_string(AutotuneState state);
+
+#endif /* AUTOTUNE_H_ */
@@ -0,0 +1,220 @@
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "global_state.h"
+#include "nvs_config.h"
+#include "asic.h"
+#include "chip_frequency.h"
+
+#define CHIP_FREQUENCY_STEP 6.25f // MHz, same step as the board frequency ramp
+#define CHIP_FREQUENCY_MAX_TRIM 100.0f
+#define CHIP_FREQUENCY_SETTLE_MS (30 * 1000)
+#define CHIP_FREQUENCY_WINDOW_MS (10 * 60 * 1000)
+#define CHIP_FREQUENCY_MAX_ERROR_PERCENTAGE 2.0f   // a chip above this is stepped down
+#define CHIP_FREQUENCY_CLEAN_ERROR_PERCENTAGE 0.5f // a window below this counts towards stepping up again
+#define CHIP_FREQUENCY_CLEAN_WINDOWS 6             // an hour without trouble before a trimmed chip is raised
+#define CHIP_FREQUENCY_PROBE_GAIN 1.01f            // hashrate a trial step has to gain to be kept
+#define CHIP_FREQUENCY_RESTART_MHZ 25.0f           // board frequency drift that restarts the measurement
+
+static const char * TAG = "chip_frequency";
+
+static uint32_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static int chip_count(GlobalState * GLOBAL_STATE)
+{
+    int count = GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+    return count < CHIP_FREQUENCY_MAX_CHIPS ? count : CHIP_FREQUENCY_MAX_CHIPS;
+}
+
+static void start_window(GlobalState * GLOBAL_STATE)
+{
+    ChipFrequencyModule * chip_frequency = &GLOBAL_STATE->CHIP_FREQUENCY_MODULE;
+    chip_frequency->window_start_ms = now_ms();
+    chip_frequency->window_frequency = GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value;
+    chip_frequency->samples = 0;
+    memset(chip_frequency->hashrate_sum, 0, sizeof(chip_frequency->hashrate_sum));
+    memset(chip_frequency->error_sum, 0, sizeof(chip_frequency->error_sum));
+}
+
+static void set_trim(GlobalState * GLOBAL_STATE, uint8_t asic_nr, float trim)
+{
+    GLOBAL_STATE->CHIP_FREQUENCY_MODULE.trim[asic_nr] = trim;
+    GLOBAL_STATE->CHIP_FREQUENCY_MODULE.clean_windows[asic_nr] = 0;
+    ASIC_set_chip_frequency(GLOBAL_STATE, asic_nr, ChipFrequency_get(GLOBAL_STATE, asic_nr));
+}
+
+void ChipFrequency_reset(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    ChipFrequencyModule * chip_frequency = &GLOBAL_STATE->CHIP_FREQUENCY_MODULE;
+
+    memset(chip_frequency, 0, sizeof(*chip_frequency));
+    chip_frequency->setting_frequency = nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY);
+    chip_frequency->setting_voltage = nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE);
+    start_window(GLOBAL_STATE);
+}
+
+float ChipFrequency_get(void * pvParameters, uint8_t asic_nr)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    float frequency = GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value;
+
+    if (asic_nr < CHIP_FREQUENCY_MAX_CHIPS) {
+        frequency -= GLOBAL_STATE->CHIP_FREQUENCY_MODULE.trim[asic_nr];
+    }
+    return frequency;
+}
+
+float ChipFrequency_average(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    int asic_count = GLOBAL_STATE->DEVICE_CONFIG.family.asic_count;
+
+    float sum = 0;
+    for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+        sum += ChipFrequency_get(GLOBAL_STATE, asic_nr);
+    }
+    return sum / asic_count;
+}
+
+void ChipFrequency_update(void * pvParameters, bool board_frequency_changed)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    ChipFrequencyModule * chip_frequency = &GLOBAL_STATE->CHIP_FREQUENCY_MODULE;
+    HashrateMonitorModule * hashrate_monitor = &GLOBAL_STATE->HASHRATE_MONITOR_MODULE;
+    int count = chip_count(GLOBAL_STATE);
+
+    // A single chip is already tuned by the board frequency, and a sweep measures the board as a whole
+    bool enabled = count > 1 && nvs_config_get_bool(NVS_CONFIG_CHIP_FREQUENCY) && !Autotune_is_running(GLOBAL_STATE);
+
+    if (!enabled || board_frequency_changed) {
+        // The broadcast already put every chip back on the board frequency
+        for (int asic_nr = 0; asic_nr < count; asic_nr++) {
+            if (chip_frequency->trim[asic_nr] <= 0) continue;
+            if (!enabled) {
+                set_trim(GLOBAL_STATE, asic_nr, 0);
+            } else {
+                ASIC_set_chip_frequency(GLOBAL_STATE, asic_nr, ChipFrequency_get(GLOBAL_STATE, asic_nr));
+            }
+        }
+    }
+
+    // The power cap and the governor move the board frequency in small steps
+    // all the time, only a changed setting or a large drift is a new situation
+    float setting_frequency = nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY);
+    uint16_t setting_voltage = nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE);
+    bool settings_changed = setting_frequency != chip_frequency->setting_frequency || setting_voltage != chip_frequency->setting_voltage;
+    bool drifted = fabsf(GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value - chip_frequency->window_frequency) > CHIP_FREQUENCY_RESTART_MHZ;
+
+    if (!enabled || settings_changed || drifted) {
+        // A new board frequency deserves a new look at the chips that fall behind
+        memset(chip_frequency->probing, 0, sizeof(chip_frequency->probing));
+        memset(chip_frequency->probe_done, 0, sizeof(chip_frequency->probe_done));
+        memset(chip_frequency->floor_trim, 0, sizeof(chip_frequency->floor_trim));
+        chip_frequency->setting_frequency = setting_frequency;
+        chip_frequency->setting_voltage = setting_voltage;
+        start_window(GLOBAL_STATE);
+        return;
+    }
+
+    if (!hashrate_monitor->is_initialized) return;
+
+    uint32_t elapsed = now_ms() - chip_frequency->window_start_ms;
+    if (elapsed < CHIP_FREQUENCY_SETTLE_MS) return;
+
+    for (int asic_nr = 0; asic_nr < count; asic_nr++) {
+        chip_frequency->hashrate_sum[asic_nr] += hashrate_monitor->total_measurement[asic_nr].hashrate;
+        chip_frequency->error_sum[asic_nr] += hashrate_monitor->error_measurement[asic_nr].hashrate;
+    }
+    chip_frequency->samples++;
+
+    if (elapsed < CHIP_FREQUENCY_SETTLE_MS + CHIP_FREQUENCY_WINDOW_MS) return;
+
+    const AsicConfig * asic = &GLOBAL_STATE->DEVICE_CONFIG.family.asic;
+    float hashrate[CHIP_FREQUENCY_MAX_CHIPS];
+    float expected[CHIP_FREQUENCY_MAX_CHIPS];
+    float error_percentage[CHIP_FREQUENCY_MAX_CHIPS];
+    bool erroring[CHIP_FREQUENCY_MAX_CHIPS];
+    bool slow[CHIP_FREQUENCY_MAX_CHIPS];
+    int erroring_count = 0;
+    int slow_count = 0;
+
+    for (int asic_nr = 0; asic_nr < count; asic_nr++) {
+        // Nothing to judge while a chip reports no hashrate
+        if (chip_frequency->hashrate_sum[asic_nr] <= 0) {
+            start_window(GLOBAL_STATE);
+            return;
+        }
+        hashrate[asic_nr] = chip_frequency->hashrate_sum[asic_nr] / chip_frequency->samples;
+        expected[asic_nr] = ChipFrequency_get(GLOBAL_STATE, asic_nr) * asic->small_core_count / 1000.0f;
+        error_percentage[asic_nr] = chip_frequency->error_sum[asic_nr] / chip_frequency->hashrate_sum[asic_nr] * 100.0f;
+        erroring[asic_nr] = error_percentage[asic_nr] > CHIP_FREQUENCY_MAX_ERROR_PERCENTAGE;
+        // A chip with dead cores falls behind at any frequency, so a low hashrate alone only earns a trial step
+        slow[asic_nr] = hashrate[asic_nr] < expected[asic_nr] * asic->hashrate_test_percentage_target;
+        if (erroring[asic_nr]) erroring_count++;
+        if (slow[asic_nr]) slow_count++;
+    }
+
+    if (erroring_count == count || slow_count == count) {
+        // Trimming every chip is a board frequency or voltage problem
+        ESP_LOGW(TAG, "All chips fall behind, leaving the board frequency to the settings");
+        start_window(GLOBAL_STATE);
+        return;
+    }
+
+    for (int asic_nr = 0; asic_nr < count; asic_nr++) {
+        float trim = chip_frequency->trim[asic_nr];
+
+        if (chip_frequency->probing[asic_nr] && !erroring[asic_nr]) {
+            chip_frequency->probing[asic_nr] = false;
+            if (hashrate[asic_nr] < chip_frequency->probe_hashrate[asic_nr] * CHIP_FREQUENCY_PROBE_GAIN) {
+                // The trial step only cost hashrate, back to where the chip was and no more trials for it
+                chip_frequency->probe_done[asic_nr] = true;
+                set_trim(GLOBAL_STATE, asic_nr, trim - CHIP_FREQUENCY_STEP);
+                ESP_LOGI(TAG, "Chip %d: %.1f of %.1f GH/s, no gain from the lower frequency, back to %g MHz", asic_nr,
+                         hashrate[asic_nr], expected[asic_nr], ChipFrequency_get(GLOBAL_STATE, asic_nr));
+                continue;
+            }
+            // The gain keeps the trial step, a chip that is still slow tries the next one below
+            chip_frequency->floor_trim[asic_nr] = trim;
+            ESP_LOGI(TAG, "Chip %d: %.1f of %.1f GH/s, keeping %g MHz", asic_nr, hashrate[asic_nr], expected[asic_nr],
+                     ChipFrequency_get(GLOBAL_STATE, asic_nr));
+        }
+        chip_frequency->probing[asic_nr] = false;
+
+        bool probe = slow[asic_nr] && !erroring[asic_nr] && !chip_frequency->probe_done[asic_nr];
+
+        if (erroring[asic_nr] || probe) {
+            if (trim + CHIP_FREQUENCY_STEP > CHIP_FREQUENCY_MAX_TRIM) {
+                ESP_LOGW(TAG, "Chip %d: %.1f of %.1f GH/s, %.2f%% errors at the lowest trim of %g MHz", asic_nr,
+                         hashrate[asic_nr], expected[asic_nr], error_percentage[asic_nr], ChipFrequency_get(GLOBAL_STATE, asic_nr));
+                chip_frequency->clean_windows[asic_nr] = 0;
+                continue;
+            }
+            if (probe) {
+                chip_frequency->probing[asic_nr] = true;
+                chip_frequency->probe_hashrate[asic_nr] = hashrate[asic_nr];
+            }
+            set_trim(GLOBAL_STATE, asic_nr, trim + CHIP_FREQUENCY_STEP);
+            ESP_LOGI(TAG, "Chip %d: %.1f of %.1f GH/s, %.2f%% errors, %s down to %g MHz", asic_nr, hashrate[asic_nr],
+                     expected[asic_nr], error_percentage[asic_nr], probe ? "trying" : "stepping",
+                     ChipFrequency_get(GLOBAL_STATE, asic_nr));
+        } else if (trim > chip_frequency->floor_trim[asic_nr] && error_percentage[asic_nr] < CHIP_FREQUENCY_CLEAN_ERROR_PERCENTAGE) {
+            // Error trims are given back after a clean hour, down to what a trial step earned
+            if (++chip_frequency->clean_windows[asic_nr] >= CHIP_FREQUENCY_CLEAN_WINDOWS) {
+                set_trim(GLOBAL_STATE, asic_nr, trim - CHIP_FREQUENCY_STEP);
+                ESP_LOGI(TAG, "Chip %d: %.1f of %.1f GH/s, %.2f%% errors, stepping up to %g MHz", asic_nr, hashrate[asic_nr],
+                         expected[asic_nr], error_percentage[asic_nr], ChipFrequency_get(GLOBAL_STATE, asic_nr));
+            }
+        } else {
+            // Between both thresholds the chip keeps its trim
+            chip_frequency->clean_windows[asic_nr] = 0;
+        }
+    }
+
+    start_window(GLOBAL_STATE);
+}
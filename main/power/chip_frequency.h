@@ -0,0 +1,51 @@
+#ifndef CHIP_FREQUENCY_H_
+#define CHIP_FREQUENCY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHIP_FREQUENCY_MAX_CHIPS 8
+
+typedef struct
+{
+    // MHz each chip runs below the board frequency
+    float trim[CHIP_FREQUENCY_MAX_CHIPS];
+    // Consecutive clean windows since the last trim change, a chip is raised again after enough of them
+    uint8_t clean_windows[CHIP_FREQUENCY_MAX_CHIPS];
+    // Trim a slow chip earned by gaining hashrate, clean windows do not raise it above this
+    float floor_trim[CHIP_FREQUENCY_MAX_CHIPS];
+    // A trial step for a slow chip is waiting for its window, probe_hashrate is GH/s before it
+    bool probing[CHIP_FREQUENCY_MAX_CHIPS];
+    float probe_hashrate[CHIP_FREQUENCY_MAX_CHIPS];
+    // A trial step did not help, the chip is left alone until the board frequency changes
+    bool probe_done[CHIP_FREQUENCY_MAX_CHIPS];
+
+    // Settings and board frequency the chips are judged at, a change restarts the window
+    float setting_frequency;
+    uint16_t setting_voltage;
+    float window_frequency;
+
+    uint32_t window_start_ms;
+    uint16_t samples;
+    float hashrate_sum[CHIP_FREQUENCY_MAX_CHIPS];
+    float error_sum[CHIP_FREQUENCY_MAX_CHIPS];
+} ChipFrequencyModule;
+
+// Drops all trims without touching the chips, for when they are reinitialized at the board frequency
+void ChipFrequency_reset(void * pvParameters);
+
+// Measures every chip and steps the ones that produce errors down
+// individually. A chip that only falls behind gets a trial step, which is
+// undone when it does not improve the chip's hashrate. Called from the power
+// management loop after the board frequency was applied.
+// board_frequency_changed re-applies the trims after the board frequency was
+// broadcast to all chips. The measurement only restarts when the settings
+// change or the board frequency drifted far from where it started.
+void ChipFrequency_update(void * pvParameters, bool board_frequency_changed);
+
+// Frequency a chip runs at in MHz
+float ChipFrequency_get(void * pvParameters, uint8_t asic_nr);
+// Average frequency over all chips in MHz
+float ChipFrequency_average(void * pvParameters);
+
+#endif /* CHIP_FREQUENCY_H_ */
@@ -0,0 +1,127 @@
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "global_state.h"
+#include "nvs_config.h"
+#include "frequency_governor.h"
+
+#define GOVERNOR_STEP 6.25f  // MHz, same step as the frequency ramp
+#define GOVERNOR_RANGE 50.0f // MHz the governor may move away from the frequency setting
+#define GOVERNOR_SETTLE_MS (30 * 1000)
+#define GOVERNOR_WINDOW_MS (5 * 60 * 1000)
+#define GOVERNOR_HOLD_MS (30 * 60 * 1000)       // after backing off, before probing upwards again
+#define GOVERNOR_LOW_ERROR_PERCENTAGE 0.5f      // below this the frequency is nudged up
+#define GOVERNOR_HIGH_ERROR_PERCENTAGE 2.0f     // above this the governor backs off
+#define GOVERNOR_TEMP_MARGIN 5.0f               // no step up while the ASIC runs this far above the temperature target
+
+static const char * TAG = "frequency_governor";
+
+static uint32_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static float ceiling(GlobalState * GLOBAL_STATE, float base_frequency)
+{
+    float ceiling = base_frequency + GOVERNOR_RANGE;
+    if (!nvs_config_get_bool(NVS_CONFIG_OVERCLOCK_ENABLED)) {
+        float highest = device_config_highest_frequency(&GLOBAL_STATE->DEVICE_CONFIG.family.asic);
+        ceiling = fminf(ceiling, fmaxf(base_frequency, highest));
+    }
+    return ceiling;
+}
+
+static void start_window(FrequencyGovernorModule * governor)
+{
+    governor->window_start_ms = now_ms();
+    governor->samples = 0;
+    governor->hashrate_sum = 0;
+    governor->error_sum = 0;
+}
+
+static void back_off(FrequencyGovernorModule * governor)
+{
+    governor->frequency = fmaxf(governor->frequency - GOVERNOR_STEP, governor->base_frequency - GOVERNOR_RANGE);
+    governor->hold_until_ms = now_ms() + GOVERNOR_HOLD_MS;
+}
+
+void FrequencyGovernor_reset(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    FrequencyGovernorModule * governor = &GLOBAL_STATE->FREQUENCY_GOVERNOR_MODULE;
+
+    memset(governor, 0, sizeof(*governor));
+}
+
+float FrequencyGovernor_update(void * pvParameters, float frequency)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    FrequencyGovernorModule * governor = &GLOBAL_STATE->FREQUENCY_GOVERNOR_MODULE;
+    PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
+    SystemModule * sys_module = &GLOBAL_STATE->SYSTEM_MODULE;
+
+    if (!nvs_config_get_bool(NVS_CONFIG_FREQUENCY_GOVERNOR)) {
+        if (governor->base_frequency != 0) {
+            FrequencyGovernor_reset(GLOBAL_STATE);
+        }
+        return frequency;
+    }
+
+    // A new setting starts over from it
+    if (frequency != governor->base_frequency) {
+        FrequencyGovernor_reset(GLOBAL_STATE);
+        governor->base_frequency = frequency;
+        governor->frequency = frequency;
+        governor->hold_until_ms = now_ms();
+        start_window(governor);
+        return frequency;
+    }
+
+    uint32_t elapsed = now_ms() - governor->window_start_ms;
+    if (elapsed < GOVERNOR_SETTLE_MS) {
+        return governor->frequency;
+    }
+
+    governor->samples++;
+    governor->hashrate_sum += sys_module->current_hashrate;
+    governor->error_sum += sys_module->error_percentage;
+
+    if (elapsed < GOVERNOR_SETTLE_MS + GOVERNOR_WINDOW_MS) {
+        return governor->frequency;
+    }
+
+    float hashrate = governor->hashrate_sum / governor->samples;
+    float error_percentage = governor->error_sum / governor->samples;
+    // Hashes reported as errors do not produce shares
+    float effective_hashrate = hashrate * (1.0f - error_percentage / 100.0f);
+
+    float probe_effective_hashrate = governor->probe_effective_hashrate;
+    governor->probe_effective_hashrate = 0;
+
+    float temperature = fmaxf(power_management->chip_temp_avg, power_management->chip_temp2_avg);
+    float temp_limit = nvs_config_get_u16(NVS_CONFIG_TEMP_TARGET) + GOVERNOR_TEMP_MARGIN;
+    bool holding = (int32_t) (now_ms() - governor->hold_until_ms) < 0;
+
+    if (hashrate <= 0) {
+        // Not mining, nothing to judge
+    } else if (error_percentage > GOVERNOR_HIGH_ERROR_PERCENTAGE) {
+        float previous = governor->frequency;
+        back_off(governor);
+        ESP_LOGI(TAG, "%.2f%% errors at %g MHz, backing off to %g MHz", error_percentage, previous, governor->frequency);
+    } else if (probe_effective_hashrate > 0 && effective_hashrate <= probe_effective_hashrate) {
+        float previous = governor->frequency;
+        back_off(governor);
+        ESP_LOGI(TAG, "%g MHz gave %.1f GH/s effective, not more than %.1f GH/s, back to %g MHz", previous,
+                 effective_hashrate, probe_effective_hashrate, governor->frequency);
+    } else if (error_percentage < GOVERNOR_LOW_ERROR_PERCENTAGE && !holding && temperature <= temp_limit &&
+               governor->frequency + GOVERNOR_STEP <= ceiling(GLOBAL_STATE, governor->base_frequency)) {
+        governor->probe_effective_hashrate = effective_hashrate;
+        governor->frequency += GOVERNOR_STEP;
+        ESP_LOGI(TAG, "%.2f%% errors, %.1f GH/s effective, trying %g MHz", error_percentage, effective_hashrate,
+                 governor->frequency);
+    }
+
+    start_window(governor);
+    return governor->frequency;
+}
@@ -0,0 +1,31 @@
+#ifndef FREQUENCY_GOVERNOR_H_
+#define FREQUENCY_GOVERNOR_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    float base_frequency; // frequency setting the governor works around, 0 before the first update
+    float frequency;      // frequency the governor asks for
+
+    // Effective hashrate of the window before the last step up, 0 when not probing
+    float probe_effective_hashrate;
+    // No step up before this time after backing off
+    uint32_t hold_until_ms;
+
+    uint32_t window_start_ms;
+    uint16_t samples;
+    float hashrate_sum;
+    float error_sum;
+} FrequencyGovernorModule;
+
+// Forgets the governor's state, the next update starts at the frequency setting again
+void FrequencyGovernor_reset(void * pvParameters);
+
+// Nudges the frequency up while the ASICs report few hardware errors and backs
+// off when the error rate rises, keeping a step up only when it raised the
+// effective hashrate. Called from the power management loop with the frequency
+// setting, returns the frequency to apply.
+float FrequencyGovernor_update(void * pvParameters, float frequency);
+
+#endif /* FREQUENCY_GOVERNOR_H_ */
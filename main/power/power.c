@@ -1,6 +1,7 @@
 #include "TPS546.h"
 #include "INA260.h"
 #include "DS4432U.h"
+#include "vcore.h"
 
 #include "power.h"
 
@@ -55,3 +56,30 @@ float Power_get_vreg_temp(GlobalState * GLOBAL_STATE)
 
     return 0.0;
 }
+
+esp_err_t Power_read(GlobalState * GLOBAL_STATE, PowerReading * reading)
+{
+    if (GLOBAL_STATE->DEVICE_CONFIG.TPS546) {
+        TPS546_TELEMETRY telemetry;
+        esp_err_t err = TPS546_read_telemetry(&telemetry);
+        if (err != ESP_OK) {
+            return err;
+        }
+        *reading = (PowerReading){0};
+        reading->voltage = telemetry.vin * 1000.0;
+        reading->current = telemetry.iout * 1000.0;
+        reading->power = telemetry.vout * reading->current / 1000.0 + GLOBAL_STATE->DEVICE_CONFIG.family.power_offset;
+        reading->core_voltage = telemetry.vout / GLOBAL_STATE->DEVICE_CONFIG.family.voltage_domains * 1000;
+        reading->vr_temp = telemetry.temperature;
+        return ESP_OK;
+    }
+
+    *reading = (PowerReading){0};
+    if (GLOBAL_STATE->DEVICE_CONFIG.INA260) {
+        reading->voltage = INA260_read_voltage();
+        reading->current = INA260_read_current();
+        reading->power = INA260_read_power() / 1000.0;
+    }
+    reading->core_voltage = VCORE_get_voltage_mv(GLOBAL_STATE);
+    return ESP_OK;
+}
@@ -9,4 +9,19 @@ float Power_get_power(GlobalState * GLOBAL_STATE);
 float Power_get_input_voltage(GlobalState * GLOBAL_STATE);
 float Power_get_vreg_temp(GlobalState * GLOBAL_STATE);
 
+typedef struct
+{
+    float voltage;        // mV input
+    float current;        // mA
+    float power;          // W
+    int16_t core_voltage; // mV
+    float vr_temp;
+} PowerReading;
+
+// Reads input voltage, current, power, core voltage and regulator temperature
+// together, touching each sensor register once; the getters above read some of
+// them again for each value. The reading is left untouched when the regulator
+// could not be read.
+esp_err_t Power_read(GlobalState * GLOBAL_STATE, PowerReading * reading);
+
 #endif // POWER_H
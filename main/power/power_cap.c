@@ -0,0 +1,93 @@
+#include <math.h>
+#include "esp_log.h"
+#include "global_state.h"
+#include "nvs_config.h"
+#include "PID.h"
+#include "power_cap.h"
+#include "sensor_task.h"
+
+#define POWER_CAP_STEP 6.25f // MHz, the cap moves the frequency in whole ramp steps
+#define POWER_CAP_STEP_TOLERANCE 0.1f // share of a step the PID output may sit below the frequency before it drops
+#define POWER_CAP_KP 2.0     // MHz per W
+#define POWER_CAP_KI 4.0     // MHz per W and second
+#define POWER_CAP_KD 0.0
+
+static const char * TAG = "power_cap";
+
+static PIDController pid;
+static double pid_input;    // W
+static double pid_output;   // MHz
+static double pid_setpoint; // W
+
+// Whole steps the frequency is held below the requested one
+static int steps = 0;
+
+bool PowerCap_is_enabled(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+
+    // Boards without a power sensor cannot be capped
+    return nvs_config_get_u16(NVS_CONFIG_POWER_CAP) > 0 && (GLOBAL_STATE->DEVICE_CONFIG.TPS546 || GLOBAL_STATE->DEVICE_CONFIG.INA260);
+}
+
+float PowerCap_update(void * pvParameters, float frequency)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+    PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
+
+    if (!PowerCap_is_enabled(GLOBAL_STATE)) {
+        if (pid_get_mode(&pid) == AUTOMATIC) {
+            pid_set_mode(&pid, MANUAL);
+            steps = 0;
+            ESP_LOGI(TAG, "Power cap off");
+        }
+        return frequency;
+    }
+
+    float lowest = fminf(device_config_lowest_frequency(&GLOBAL_STATE->DEVICE_CONFIG.family.asic), frequency);
+    if (frequency - lowest < POWER_CAP_STEP) {
+        return frequency;
+    }
+
+    SensorSnapshot sensors;
+    Sensor_get_snapshot(&sensors);
+    if (!Sensor_power_is_valid(&sensors)) {
+        // Without a power reading the cap holds its last step
+        return fmaxf(frequency - steps * POWER_CAP_STEP, lowest);
+    }
+    power_management->power = sensors.power;
+    pid_input = power_management->power;
+    pid_setpoint = nvs_config_get_u16(NVS_CONFIG_POWER_CAP);
+
+    if (pid_get_mode(&pid) != AUTOMATIC) {
+        // Start at the requested frequency, the cap only ever pulls it down
+        pid_output = frequency;
+        steps = 0;
+        pid_init(&pid, &pid_input, &pid_output, &pid_setpoint, POWER_CAP_KP, POWER_CAP_KI, POWER_CAP_KD, PID_P_ON_E, PID_DIRECT);
+        pid_set_sample_time(&pid, POWER_CAP_POLL_RATE - 1);
+        pid_set_output_limits(&pid, lowest, frequency);
+        pid_set_mode(&pid, AUTOMATIC);
+        ESP_LOGI(TAG, "Capping power at %.0f W, between %g and %g MHz", pid_setpoint, lowest, frequency);
+    }
+
+    pid_set_output_limits(&pid, lowest, frequency);
+    pid_compute(&pid);
+
+    // Steps are rounded down so the power stays under the cap, and only given
+    // back once the output reached the step above, so noise does not toggle
+    // between two steps
+    float below = (frequency - (float) pid_output) / POWER_CAP_STEP;
+    int previous_steps = steps;
+    if (below > steps + POWER_CAP_STEP_TOLERANCE || below <= steps - 1) {
+        steps = fmaxf(ceilf(below - POWER_CAP_STEP_TOLERANCE), 0);
+    }
+    float capped = fmaxf(frequency - steps * POWER_CAP_STEP, lowest);
+
+    if (steps > 0 && previous_steps == 0) {
+        ESP_LOGI(TAG, "%.2f W at the %.0f W cap, limiting to %g MHz", pid_input, pid_setpoint, capped);
+    } else if (steps == 0 && previous_steps > 0) {
+        ESP_LOGI(TAG, "%.2f W below the %.0f W cap, back at %g MHz", pid_input, pid_setpoint, frequency);
+    }
+
+    return capped;
+}
@@ -0,0 +1,16 @@
+#ifndef POWER_CAP_H_
+#define POWER_CAP_H_
+
+#include <stdbool.h>
+
+#define POWER_CAP_POLL_RATE 300 // ms, the power management loop runs the cap this often
+
+// True while a power cap is configured
+bool PowerCap_is_enabled(void * pvParameters);
+
+// Takes the input power from the latest sensor snapshot and returns the
+// highest frequency up to the requested one that keeps the power at the cap,
+// or the requested frequency when no cap is configured.
+float PowerCap_update(void * pvParameters, float frequency);
+
+#endif /* POWER_CAP_H_ */
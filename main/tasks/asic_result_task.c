@@ -5,11 +5,14 @@
 #include "serial.h"
 #include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_config.h"
 #include "utils.h"
 #include "stratum_task.h"
 #include "hashrate_monitor_task.h"
+#include "nonce_trace_task.h"
 #include "asic.h"
+#include "frequency_transition_bmXX.h"
 
 static const char *TAG = "asic_result";
 
@@ -33,11 +36,18 @@ void ASIC_result_task(void *pvParameters)
             continue;
         }
 
+        if (asic_result->register_type == REGISTER_PLL_PARAMETER) {
+            frequency_transition_pll_read(asic_result->asic_nr, asic_result->value);
+            continue;
+        }
+
         if (asic_result->register_type != REGISTER_INVALID) {
             hashrate_monitor_register_read(GLOBAL_STATE, asic_result->register_type, asic_result->asic_nr, asic_result->value);
             continue;
         }
 
+        hashrate_monitor_nonce_found(GLOBAL_STATE, asic_result->asic_nr, asic_result->core_id, asic_result->small_core_id);
+
         uint8_t job_id = asic_result->job_id;
 
         if (GLOBAL_STATE->valid_jobs[job_id] == 0)
@@ -50,10 +60,28 @@ void ASIC_result_task(void *pvParameters)
         // check the nonce difficulty
         double nonce_diff = test_nonce_value(active_job, asic_result->nonce, asic_result->rolled_version);
 
-        //log the ASIC response
-        ESP_LOGI(TAG, "ID: %s, ASIC nr: %d, ver: %08" PRIX32 " Nonce %08" PRIX32 " diff %.1f of %ld.", active_job->jobid, asic_result->asic_nr, asic_result->rolled_version, asic_result->nonce, nonce_diff, active_job->pool_diff);
+        // Trace the ASIC response, the text is rendered later by the trace task
+        nonce_trace_record record = {
+            .timestamp_us = esp_timer_get_time(),
+            .nonce = asic_result->nonce,
+            .rolled_version = asic_result->rolled_version,
+            .pool_diff = active_job->pool_diff,
+            .diff = nonce_diff,
+            .job_id = job_id,
+            .asic_nr = asic_result->asic_nr,
+            .core_id = asic_result->core_id,
+            .small_core_id = asic_result->small_core_id,
+        };
+        strlcpy(record.jobid, active_job->jobid, sizeof(record.jobid));
+        nonce_trace_push(&record);
 
-        if (nonce_diff >= active_job->pool_diff)
+        if (nonce_diff >= active_job->pool_diff && active_job->prevhash_epoch != GLOBAL_STATE->prevhash_epoch)
+        {
+            // The pool already invalidated this job, submitting would only earn a reject
+            ESP_LOGW(TAG, "Dropping stale share for job %s", active_job->jobid);
+            SYSTEM_notify_stale_share(GLOBAL_STATE);
+        }
+        else if (nonce_diff >= active_job->pool_diff)
         {
             char * user = GLOBAL_STATE->SYSTEM_MODULE.is_using_fallback ? GLOBAL_STATE->SYSTEM_MODULE.fallback_pool_user : GLOBAL_STATE->SYSTEM_MODULE.pool_user;
             int ret = STRATUM_V1_submit_share(
@@ -43,6 +43,12 @@ void ASIC_task(void *pvParameters)
         }
         
         bm_job *next_bm_job = (bm_job *)queue_dequeue(&GLOBAL_STATE->ASIC_jobs_queue);
+
+        // Generated just before a clean_jobs notify; sending it would only produce stale shares
+        if (next_bm_job->prevhash_epoch != GLOBAL_STATE->prevhash_epoch) {
+            free_bm_job(next_bm_job);
+            continue;
+        }
     
         //(*GLOBAL_STATE->ASIC_functions.send_work_fn)(GLOBAL_STATE, next_bm_job); // send the job to the ASIC
         ASIC_send_work(GLOBAL_STATE, next_bm_job);
@@ -5,8 +5,10 @@
 #include "global_state.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_random.h"
 #include "mining.h"
 #include "string.h"
+#include "nvs_config.h"
 
 #include "asic.h"
 
@@ -14,8 +16,15 @@ static const char *TAG = "create_jobs_task";
 
 #define QUEUE_LOW_WATER_MARK 10 // Adjust based on your requirements
 
+// Jobs are broadcast to every chip, which already split the nonce range by chip address,
+// so the extranonce2 space is used as a single partition.
+#define EXTRANONCE_2_PARTITIONS 1
+
+static extranonce_2_allocator extranonce_2_alloc;
+
 static bool should_generate_more_work(GlobalState *GLOBAL_STATE);
-static void generate_work(GlobalState *GLOBAL_STATE, mining_notify *notification, uint64_t extranonce_2, uint32_t difficulty);
+static bool generate_work(GlobalState *GLOBAL_STATE, mining_notify *notification, uint64_t extranonce_2, uint32_t difficulty, uint32_t epoch, bm_job *template);
+static bool enqueue_job(GlobalState *GLOBAL_STATE, const bm_job *template, uint32_t ntime_offset);
 
 void create_jobs_task(void *pvParameters)
 {
@@ -33,6 +42,9 @@ void create_jobs_task(void *pvParameters)
 
         ESP_LOGI(TAG, "New Work Dequeued %s", mining_notification->job_id);
 
+        // Stamped when queued, the global epoch may already have moved on to a newer notify
+        uint32_t epoch = mining_notification->prevhash_epoch;
+
         if (GLOBAL_STATE->new_set_mining_difficulty_msg)
         {
             ESP_LOGI(TAG, "New pool difficulty %lu", GLOBAL_STATE->pool_difficulty);
@@ -46,15 +58,42 @@ void create_jobs_task(void *pvParameters)
             GLOBAL_STATE->new_stratum_version_rolling_msg = false;
         }
 
-        uint64_t extranonce_2 = 0;
+        uint64_t seed = ((uint64_t)esp_random() << 32) | esp_random();
+        if (extranonce_2_allocator_session(&extranonce_2_alloc, GLOBAL_STATE->extranonce_str, GLOBAL_STATE->extranonce_2_len,
+                                           EXTRANONCE_2_PARTITIONS, seed)) {
+            ESP_LOGI(TAG, "New extranonce2 session for extranonce1 %s", GLOBAL_STATE->extranonce_str);
+        }
+
+        // Rolled ntime jobs reuse the last merkle root and midstates, skipping the coinbase and merkle hashing
+        uint16_t ntime_roll_window = nvs_config_get_u16(NVS_CONFIG_NTIME_ROLL_WINDOW);
+        uint32_t ntime_offset = 0;
+        bool have_template = false;
+        bm_job template = { 0 };
+
         while (GLOBAL_STATE->stratum_queue.count < 1 && GLOBAL_STATE->abandon_work == 0)
         {
             if (should_generate_more_work(GLOBAL_STATE))
             {
-                generate_work(GLOBAL_STATE, mining_notification, extranonce_2, difficulty);
-
-                // Increase extranonce_2 for the next job.
-                extranonce_2++;
+                if (have_template && ntime_offset < ntime_roll_window) {
+                    if (enqueue_job(GLOBAL_STATE, &template, ntime_offset + 1)) {
+                        ntime_offset++;
+                        GLOBAL_STATE->SYSTEM_MODULE.jobs_ntime_rolled++;
+                    } else {
+                        // Give the heap a moment instead of spinning on it
+                        vTaskDelay(100 / portTICK_PERIOD_MS);
+                    }
+                } else {
+                    free(template.jobid);
+                    free(template.extranonce2);
+
+                    // Continues from the session high-water mark, so reconnects never repeat work
+                    uint64_t extranonce_2 = extranonce_2_allocator_next(&extranonce_2_alloc, 0);
+                    have_template = generate_work(GLOBAL_STATE, mining_notification, extranonce_2, difficulty, epoch, &template);
+                    ntime_offset = 0;
+                    if (have_template && !enqueue_job(GLOBAL_STATE, &template, 0)) {
+                        vTaskDelay(100 / portTICK_PERIOD_MS);
+                    }
+                }
             }
             else
             {
@@ -70,6 +109,8 @@ void create_jobs_task(void *pvParameters)
             xSemaphoreGive(GLOBAL_STATE->ASIC_TASK_MODULE.semaphore);
         }
 
+        free(template.jobid);
+        free(template.extranonce2);
         STRATUM_V1_free_mining_notify(mining_notification);
     }
 }
@@ -79,7 +120,7 @@ static bool should_generate_more_work(GlobalState *GLOBAL_STATE)
     return GLOBAL_STATE->ASIC_jobs_queue.count < QUEUE_LOW_WATER_MARK;
 }
 
-static void generate_work(GlobalState *GLOBAL_STATE, mining_notify *notification, uint64_t extranonce_2, uint32_t difficulty)
+static bool generate_work(GlobalState *GLOBAL_STATE, mining_notify *notification, uint64_t extranonce_2, uint32_t difficulty, uint32_t epoch, bm_job *template)
 {
     char extranonce_2_str[GLOBAL_STATE->extranonce_2_len * 2 + 1];
     extranonce_2_generate(extranonce_2, GLOBAL_STATE->extranonce_2_len, extranonce_2_str);
@@ -93,18 +134,43 @@ static void generate_work(GlobalState *GLOBAL_STATE, mining_notify *notification
     uint8_t merkle_root[32];
     calculate_merkle_root_hash(coinbase_tx_hash, (uint8_t(*)[32])notification->merkle_branches, notification->n_merkle_branches, merkle_root);
 
+    construct_bm_job(notification, merkle_root, GLOBAL_STATE->version_mask, difficulty, template);
+
+    template->extranonce2 = strdup(extranonce_2_str);
+    template->jobid = strdup(notification->job_id);
+    template->version_mask = GLOBAL_STATE->version_mask;
+    template->prevhash_epoch = epoch;
+
+    if (template->extranonce2 == NULL || template->jobid == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for new job");
+        return false;
+    }
+    return true;
+}
+
+static bool enqueue_job(GlobalState *GLOBAL_STATE, const bm_job *template, uint32_t ntime_offset)
+{
     bm_job *queued_next_job = malloc(sizeof(bm_job));
 
     if (queued_next_job == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for new job");
-        return;
+        return false;
     }
 
-    construct_bm_job(notification, merkle_root, GLOBAL_STATE->version_mask, difficulty, queued_next_job);
+    *queued_next_job = *template;
+    queued_next_job->ntime = template->ntime + ntime_offset;
+    queued_next_job->extranonce2 = strdup(template->extranonce2);
+    queued_next_job->jobid = strdup(template->jobid);
 
-    queued_next_job->extranonce2 = strdup(extranonce_2_str);
-    queued_next_job->jobid = strdup(notification->job_id);
-    queued_next_job->version_mask = GLOBAL_STATE->version_mask;
+    if (queued_next_job->extranonce2 == NULL || queued_next_job->jobid == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for new job");
+        free(queued_next_job->extranonce2);
+        free(queued_next_job->jobid);
+        free(queued_next_job);
+        return false;
+    }
 
     queue_enqueue(&GLOBAL_STATE->ASIC_jobs_queue, queued_next_job);
+    GLOBAL_STATE->SYSTEM_MODULE.jobs_generated++;
+    return true;
 }
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <pthread.h>
 #include <esp_heap_caps.h>
 #include <math.h>
 #include "esp_log.h"
@@ -19,6 +20,8 @@
 #define DIV_10M (HASHRATE_1M_SIZE)
 #define DIV_1H (HASHRATE_10M_SIZE * DIV_10M)
 
+#define CORE_NONCES_DECAY_MS (6 * 60 * 60 * 1000) // halve the nonce histogram every 6 hours
+
 static unsigned long poll_count = 0;
 static float hashrate_1m[HASHRATE_1M_SIZE];
 static float hashrate_10m_prev;
@@ -28,6 +31,9 @@ static float hashrate_1h[HASHRATE_1H_SIZE];
 
 static const char *TAG = "hashrate_monitor";
 
+// Serializes the nonce counts of the result task with the periodic decay
+static pthread_mutex_t core_nonces_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static float sum_hashrates(measurement_t * measurement, int asic_count)
 {
     if (asic_count == 1) return measurement[0].hashrate;
@@ -51,6 +57,16 @@ static void clear_measurements(GlobalState * GLOBAL_STATE)
     memset(HASHRATE_MONITOR_MODULE->error_measurement, 0, asic_count * sizeof(measurement_t));
 }
 
+static void decay_core_nonces(uint16_t * core_nonces, int asic_count)
+{
+    // One chip at a time, the result task waits for at most one chip
+    for (int asic_nr = 0; asic_nr < asic_count; asic_nr++) {
+        pthread_mutex_lock(&core_nonces_lock);
+        core_nonces_decay(&core_nonces[asic_nr * CORE_NONCES_CHIP_SIZE], CORE_NONCES_CHIP_SIZE);
+        pthread_mutex_unlock(&core_nonces_lock);
+    }
+}
+
 static void update_hashrate(measurement_t * measurement, uint32_t value)
 {
     uint8_t flag_long = (value & 0x80000000) >> 31;
@@ -146,12 +162,19 @@ void hashrate_monitor_task(void *pvParameters)
     }
     HASHRATE_MONITOR_MODULE->error_measurement = heap_caps_malloc(asic_count * sizeof(measurement_t), MALLOC_CAP_SPIRAM);
 
+    // BM1397 results do not identify the core that found the nonce
+    if (GLOBAL_STATE->DEVICE_CONFIG.family.asic.id != BM1397) {
+        HASHRATE_MONITOR_MODULE->core_nonces = heap_caps_calloc(asic_count * CORE_NONCES_CHIP_SIZE, sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    }
+
     clear_measurements(GLOBAL_STATE);
 
     init_averages();
 
     HASHRATE_MONITOR_MODULE->is_initialized = true;
 
+    uint32_t core_nonces_decay_ms = esp_timer_get_time() / 1000;
+
     TickType_t taskWakeTime = xTaskGetTickCount();
     while (1) {
         ASIC_read_registers(GLOBAL_STATE);
@@ -166,6 +189,12 @@ void hashrate_monitor_task(void *pvParameters)
 
         if(current_hashrate > 0.0f) update_hashrate_averages(SYSTEM_MODULE);
 
+        uint32_t now_ms = esp_timer_get_time() / 1000;
+        if (HASHRATE_MONITOR_MODULE->core_nonces != NULL && now_ms - core_nonces_decay_ms >= CORE_NONCES_DECAY_MS) {
+            decay_core_nonces(HASHRATE_MONITOR_MODULE->core_nonces, asic_count);
+            core_nonces_decay_ms = now_ms;
+        }
+
         vTaskDelayUntil(&taskWakeTime, POLL_RATE / portTICK_PERIOD_MS);
     }
 }
@@ -207,12 +236,66 @@ void hashrate_monitor_register_read(void *pvParameters, register_type_t register
         case REGISTER_ERROR_COUNT:
             update_hash_counter(&HASHRATE_MONITOR_MODULE->error_measurement[asic_nr], value, time_ms);
             break;
+        case REGISTER_PLL_PARAMETER: // handled by the frequency transition
         case REGISTER_INVALID:
             ESP_LOGE(TAG, "Invalid register type");
             break;
     }
 }
 
+void hashrate_monitor_nonce_found(void *pvParameters, uint8_t asic_nr, uint8_t core_id, uint8_t small_core_id)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *)pvParameters;
+    uint16_t * core_nonces = GLOBAL_STATE->HASHRATE_MONITOR_MODULE.core_nonces;
+
+    if (core_nonces == NULL) return;
+
+    if (asic_nr >= GLOBAL_STATE->DEVICE_CONFIG.family.asic_count || core_id >= CORE_NONCES_CORES || small_core_id >= CORE_NONCES_SMALL_CORES) {
+        ESP_LOGE(TAG, "Core out of bounds [%d:%d/%d]", asic_nr, core_id, small_core_id);
+        return;
+    }
+
+    pthread_mutex_lock(&core_nonces_lock);
+    core_nonces_add(&core_nonces[asic_nr * CORE_NONCES_CHIP_SIZE], core_id, small_core_id);
+    pthread_mutex_unlock(&core_nonces_lock);
+}
+
+uint16_t * hashrate_monitor_core_nonces(void *pvParameters, uint8_t asic_nr, uint8_t core_id)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *)pvParameters;
+    uint16_t * core_nonces = GLOBAL_STATE->HASHRATE_MONITOR_MODULE.core_nonces;
+
+    if (core_nonces == NULL || asic_nr >= GLOBAL_STATE->DEVICE_CONFIG.family.asic_count || core_id >= CORE_NONCES_CORES) {
+        return NULL;
+    }
+    return &core_nonces[asic_nr * CORE_NONCES_CHIP_SIZE + core_id * CORE_NONCES_SMALL_CORES];
+}
+
+uint32_t hashrate_monitor_core_total(void *pvParameters, uint8_t asic_nr, uint8_t core_id)
+{
+    uint16_t * chip_nonces = hashrate_monitor_core_nonces(pvParameters, asic_nr, 0);
+    if (chip_nonces == NULL || core_id >= CORE_NONCES_CORES) return 0;
+
+    pthread_mutex_lock(&core_nonces_lock);
+    uint32_t total = core_nonces_core_total(chip_nonces, core_id);
+    pthread_mutex_unlock(&core_nonces_lock);
+    return total;
+}
+
+int hashrate_monitor_low_cores(void *pvParameters, uint8_t asic_nr, uint8_t * low_cores, int max_low_cores)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *)pvParameters;
+
+    uint16_t * chip_nonces = hashrate_monitor_core_nonces(pvParameters, asic_nr, 0);
+    if (chip_nonces == NULL) return 0;
+
+    // Judged on one consistent state of the chip, not half way through a decay
+    pthread_mutex_lock(&core_nonces_lock);
+    int found = core_nonces_low_cores(chip_nonces, GLOBAL_STATE->DEVICE_CONFIG.family.asic.core_count, low_cores, max_low_cores);
+    pthread_mutex_unlock(&core_nonces_lock);
+    return found;
+}
+
 /*
     // From NerdAxe codebase, temparature conversion?
     if (asic_result.data & 0x80000000) {
@@ -2,6 +2,7 @@
 #define HASHRATE_MONITOR_TASK_H_
 
 #include "common.h"
+#include "core_nonces.h"
 
 typedef struct {
     uint32_t value;
@@ -14,10 +15,21 @@ typedef struct {
     measurement_t** domain_measurements;
     measurement_t* error_measurement;
 
+    // Nonces found per [asic][core][small core], halved periodically so old
+    // results fade out. NULL when the ASIC does not report core ids.
+    uint16_t* core_nonces;
+
     bool is_initialized;
 } HashrateMonitorModule;
 
 void hashrate_monitor_task(void *pvParameters);
 void hashrate_monitor_register_read(void *pvParameters, register_type_t register_type, uint8_t asic_nr, uint32_t value);
+void hashrate_monitor_nonce_found(void *pvParameters, uint8_t asic_nr, uint8_t core_id, uint8_t small_core_id);
+
+uint16_t * hashrate_monitor_core_nonces(void *pvParameters, uint8_t asic_nr, uint8_t core_id);
+uint32_t hashrate_monitor_core_total(void *pvParameters, uint8_t asic_nr, uint8_t core_id);
+// Fills low_cores with the cores whose share of the chip's nonces is
+// statistically too low and returns how many were found
+int hashrate_monitor_low_cores(void *pvParameters, uint8_t asic_nr, uint8_t * low_cores, int max_low_cores);
 
 #endif /* HASHRATE_MONITOR_TASK_H_ */
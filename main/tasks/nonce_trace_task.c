@@ -0,0 +1,63 @@
+#include <inttypes.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "websocket.h"
+#include "nonce_trace_task.h"
+
+#define NONCE_TRACE_DRAIN_MS 250
+
+static const char * TAG = "nonce_trace";
+
+static nonce_trace_record ring[NONCE_TRACE_SIZE];
+// head is only written by the producer, tail only by the drain task
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t dropped = 0;
+
+void nonce_trace_push(const nonce_trace_record * record)
+{
+    uint32_t current_head = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    if (current_head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= NONCE_TRACE_SIZE) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    ring[current_head & (NONCE_TRACE_SIZE - 1)] = *record;
+    __atomic_store_n(&head, current_head + 1, __ATOMIC_RELEASE);
+}
+
+void nonce_trace_task(void * pvParameters)
+{
+    while (1) {
+        vTaskDelay(NONCE_TRACE_DRAIN_MS / portTICK_PERIOD_MS);
+
+        uint32_t current_tail = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        uint32_t current_head = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+
+        // Text is only rendered for a websocket client, or on the serial console
+        // once the nonce_trace log level is raised to debug
+        esp_log_level_t level = esp_log_level_get(TAG);
+        bool render = level >= ESP_LOG_DEBUG || (level >= ESP_LOG_INFO && websocket_has_clients());
+
+        for (; current_tail != current_head; current_tail++) {
+            if (render) {
+                const nonce_trace_record * record = &ring[current_tail & (NONCE_TRACE_SIZE - 1)];
+                ESP_LOGI(TAG, "ID: %s, ASIC nr: %d, core: %d/%d, ver: %08" PRIX32 " Nonce %08" PRIX32 " diff %.1f of %" PRIu32 " (%" PRIi64 " ms ago).",
+                         record->jobid, record->asic_nr, record->core_id, record->small_core_id, record->rolled_version,
+                         record->nonce, record->diff, record->pool_diff, (esp_timer_get_time() - record->timestamp_us) / 1000);
+            }
+            // Hand the slot back after every record so the producer can reuse it right away
+            __atomic_store_n(&tail, current_tail + 1, __ATOMIC_RELEASE);
+        }
+
+        uint32_t lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+        if (lost > 0 && render) {
+            ESP_LOGW(TAG, "Trace ring full, %" PRIu32 " nonces not logged", lost);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef NONCE_TRACE_TASK_H_
+#define NONCE_TRACE_TASK_H_
+
+#include <stdint.h>
+
+#define NONCE_TRACE_SIZE 64 // power of two
+#define NONCE_TRACE_JOBID_SIZE 16
+
+typedef struct
+{
+    int64_t timestamp_us;
+    uint32_t nonce;
+    uint32_t rolled_version;
+    uint32_t pool_diff;
+    float diff;
+    uint8_t job_id;
+    uint8_t asic_nr;
+    uint8_t core_id;
+    uint8_t small_core_id;
+    char jobid[NONCE_TRACE_JOBID_SIZE];
+} nonce_trace_record;
+
+// Copies the record into the trace ring without formatting anything.
+// Single producer (ASIC result task); the record is dropped when the ring is full.
+void nonce_trace_push(const nonce_trace_record * record);
+
+void nonce_trace_task(void * pvParameters);
+
+#endif // NONCE_TRACE_TASK_H_
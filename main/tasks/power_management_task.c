@@ -12,12 +12,17 @@
 #include "vcore.h"
 #include "thermal.h"
 #include "PID.h"
-#include "power.h"
 #include "asic.h"
 #include "bm1370.h"
 #include "utils.h"
 #include "asic_init.h"
 #include "asic_reset.h"
+#include "autotune.h"
+#include "chip_frequency.h"
+#include "frequency_governor.h"
+#include "power_cap.h"
+#include "thermal_model.h"
+#include "sensor_task.h"
 #include "driver/uart.h"
 
 #define EPSILON 0.0001f
@@ -26,6 +31,8 @@
 #define THROTTLE_TEMP 75.0
 #define SAFE_TEMP 45.0
 #define THROTTLE_TEMP_RANGE (MAX_TEMP - THROTTLE_TEMP)
+#define THROTTLE_STEP 6.25f       // MHz, same step as the frequency ramp
+#define THROTTLE_HYSTERESIS 1.0f  // °C the ASIC has to cool down before a throttle step is given back
 
 #define VOLTAGE_START_THROTTLE 4900
 #define VOLTAGE_MIN_THROTTLE 3500
@@ -56,11 +63,60 @@ int pid_startup_counter = 0;
 
 PIDController pid;
 
+// Whole steps the thermal throttle holds the frequency below the requested one
+static int throttle_steps = 0;
+
 static float expected_hashrate(GlobalState * GLOBAL_STATE, float frequency)
 {
     return frequency * GLOBAL_STATE->DEVICE_CONFIG.family.asic.small_core_count * GLOBAL_STATE->DEVICE_CONFIG.family.asic_count / 1000.0;
 }
 
+// Lowers the frequency in proportion to how far the ASIC is into the
+// THROTTLE_TEMP..MAX_TEMP band, down to the lowest frequency option at MAX_TEMP
+static float throttle_frequency(GlobalState * GLOBAL_STATE, float frequency, float temperature)
+{
+    float lowest = fminf(device_config_lowest_frequency(&GLOBAL_STATE->DEVICE_CONFIG.family.asic), frequency);
+    float range_steps = (frequency - lowest) / THROTTLE_STEP;
+
+    // Without a valid reading (-1) the throttle holds, a stuck sensor must not release it
+    if (temperature < 0) {
+        throttle_steps = fminf(throttle_steps, ceilf(range_steps));
+        return fmaxf(frequency - throttle_steps * THROTTLE_STEP, lowest);
+    }
+
+    float hot_steps = range_steps * (temperature - THROTTLE_TEMP) / THROTTLE_TEMP_RANGE;
+    float cool_steps = range_steps * (temperature + THROTTLE_HYSTERESIS - THROTTLE_TEMP) / THROTTLE_TEMP_RANGE;
+
+    int previous_steps = throttle_steps;
+    if (hot_steps > throttle_steps) {
+        throttle_steps = ceilf(hot_steps);
+    } else if (ceilf(cool_steps) < throttle_steps) {
+        throttle_steps = fmaxf(ceilf(cool_steps), 0);
+    }
+    throttle_steps = fminf(throttle_steps, ceilf(range_steps));
+
+    float throttled = fmaxf(frequency - throttle_steps * THROTTLE_STEP, lowest);
+    if (throttle_steps != previous_steps) {
+        if (throttle_steps == 0) {
+            ESP_LOGI(TAG, "ASIC cooled down to %.1f °C, throttle released", temperature);
+        } else if (previous_steps == 0) {
+            ESP_LOGW(TAG, "ASIC at %.1f °C, throttling to %g MHz", temperature, throttled);
+        } else {
+            ESP_LOGI(TAG, "ASIC at %.1f °C, throttling to %g MHz", temperature, throttled);
+        }
+    }
+    return throttled;
+}
+
+static bool set_asic_frequency(GlobalState * GLOBAL_STATE, float frequency)
+{
+    if (!ASIC_set_frequency(GLOBAL_STATE, frequency)) {
+        return false;
+    }
+    GLOBAL_STATE->POWER_MANAGEMENT_MODULE.frequency_value = frequency;
+    return true;
+}
+
 void POWER_MANAGEMENT_init_frequency(void * pvParameters)
 {
     GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
@@ -83,8 +139,10 @@ void POWER_MANAGEMENT_task(void * pvParameters)
 
     PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
     SystemModule * sys_module = &GLOBAL_STATE->SYSTEM_MODULE;
+    AutotuneModule * autotune = &GLOBAL_STATE->AUTOTUNE_MODULE;
 
     POWER_MANAGEMENT_init_frequency(GLOBAL_STATE);
+    ChipFrequency_reset(GLOBAL_STATE);
     
     float last_asic_frequency = power_management->frequency_value;
 
@@ -103,23 +161,45 @@ void POWER_MANAGEMENT_task(void * pvParameters)
     uint16_t last_known_asic_voltage = 0;
     float last_known_asic_frequency = 0.0;
 
+    // An interrupted sweep starts over, a finished one is kept across reboots
+    uint16_t last_autotune_mode = nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_MODE);
+    if (last_autotune_mode != AUTOTUNE_MODE_OFF && !nvs_config_get_bool(NVS_CONFIG_AUTOTUNED)) {
+        Autotune_start(GLOBAL_STATE, last_autotune_mode);
+    }
+
+    bool last_fan_feed_forward = false;
+
     while (1) {
 
         // Refresh PID setpoint from NVS in case it was changed via API
         pid_setPoint = (double)nvs_config_get_u16(NVS_CONFIG_TEMP_TARGET);
 
-        power_management->voltage = Power_get_input_voltage(GLOBAL_STATE);
-        power_management->power = Power_get_power(GLOBAL_STATE);
+        SensorSnapshot sensors;
+        if (!Sensor_get_snapshot(&sensors)) {
+            // Treated like a failed temperature reading, which runs the fan at 100%
+            ESP_LOGW(TAG, "No recent sensor readings");
+            sensors.chip_temp = -1;
+            sensors.chip_temp2 = -1;
+        }
+
+        // A failed power reading keeps the previous values instead of reporting 0 W
+        bool power_valid = Sensor_power_is_valid(&sensors);
+        if (power_valid) {
+            power_management->voltage = sensors.voltage;
+            power_management->current = sensors.current;
+            power_management->power = sensors.power;
+        }
 
-        power_management->fan_rpm = Thermal_get_fan_speed(&GLOBAL_STATE->DEVICE_CONFIG);
-        power_management->fan2_rpm = Thermal_get_fan2_speed(&GLOBAL_STATE->DEVICE_CONFIG);
-        power_management->chip_temp_avg = Thermal_get_chip_temp(GLOBAL_STATE);
-        power_management->chip_temp2_avg = Thermal_get_chip_temp2(GLOBAL_STATE);
+        power_management->fan_rpm = sensors.fan_rpm;
+        power_management->fan2_rpm = sensors.fan2_rpm;
+        power_management->chip_temp_avg = sensors.chip_temp;
+        power_management->chip_temp2_avg = sensors.chip_temp2;
 
-        power_management->vr_temp = Power_get_vreg_temp(GLOBAL_STATE);
+        power_management->vr_temp = sensors.vr_temp;
+        // Between THROTTLE_TEMP and MAX_TEMP the frequency is throttled, past it the ASIC is shut down
         bool asic_overheat = 
-            power_management->chip_temp_avg > THROTTLE_TEMP
-            || power_management->chip_temp2_avg > THROTTLE_TEMP;
+            power_management->chip_temp_avg > MAX_TEMP
+            || power_management->chip_temp2_avg > MAX_TEMP;
         
         if ((power_management->vr_temp > TPS546_THROTTLE_TEMP || asic_overheat) && (power_management->frequency_value > 50 || power_management->voltage > 1000)) {
             if (power_management->chip_temp2_avg > 0) {
@@ -130,6 +210,12 @@ void POWER_MANAGEMENT_task(void * pvParameters)
             power_management->fan_perc = 100;
             Thermal_set_fan_percent(&GLOBAL_STATE->DEVICE_CONFIG, 1);
 
+            if (Autotune_is_running(GLOBAL_STATE)) {
+                Autotune_stop(GLOBAL_STATE);
+            }
+            // The chips come back from reset at the board frequency
+            ChipFrequency_reset(GLOBAL_STATE);
+            ThermalModel_reset();
             VCORE_set_voltage(GLOBAL_STATE, 0.0f);
             
             ESP_LOGI(TAG, "Setting RST pin to low due to overheat condition");
@@ -153,12 +239,13 @@ void POWER_MANAGEMENT_task(void * pvParameters)
                 vTaskDelay(5000 / portTICK_PERIOD_MS); // Wait 5 seconds
                 cooling_cycles++;
                 
-                power_management->vr_temp = Power_get_vreg_temp(GLOBAL_STATE);
+                Sensor_get_snapshot(&sensors);
+                power_management->vr_temp = sensors.vr_temp;
                 
                 // Only check ASIC temps if they're valid (not using ASIC thermal diode)
                 if (asic_temp_valid) {
-                    power_management->chip_temp_avg = Thermal_get_chip_temp(GLOBAL_STATE);
-                    power_management->chip_temp2_avg = Thermal_get_chip_temp2(GLOBAL_STATE);
+                    power_management->chip_temp_avg = sensors.chip_temp;
+                    power_management->chip_temp2_avg = sensors.chip_temp2;
                     ESP_LOGW(TAG, "Safe mode active (cycle %d) - VR: %.1fC ASIC1: %.1fC ASIC2: %.1fC",
                              cooling_cycles, power_management->vr_temp, power_management->chip_temp_avg, power_management->chip_temp2_avg);
                     
@@ -207,6 +294,17 @@ void POWER_MANAGEMENT_task(void * pvParameters)
             }
         }
 
+        // The feed-forward learns the board anew whenever it is switched on, and
+        // pauses while the input power is unknown
+        bool fan_feed_forward = nvs_config_get_bool(NVS_CONFIG_AUTO_FAN_SPEED) && nvs_config_get_bool(NVS_CONFIG_FAN_FEED_FORWARD) && power_valid;
+        if (fan_feed_forward && !last_fan_feed_forward) {
+            ThermalModel_reset();
+        }
+        last_fan_feed_forward = fan_feed_forward;
+        if (!fan_feed_forward) {
+            power_management->thermal_time_constant = 0;
+        }
+
         //enable the PID auto control for the FAN if set
         if (nvs_config_get_bool(NVS_CONFIG_AUTO_FAN_SPEED)) {
             if (power_management->chip_temp_avg >= 0) { // Ignore invalid temperature readings (-1)
@@ -247,12 +345,23 @@ void POWER_MANAGEMENT_task(void * pvParameters)
                 // Uncomment for debugging PID output directly after compute
                 // ESP_LOGD(TAG, "DEBUG: PID raw output: %.2f%%, Input: %.1f, SetPoint: %.1f", pid_output, pid_input, pid_setPoint);
 
-                power_management->fan_perc = pid_output;
-                if (Thermal_set_fan_percent(&GLOBAL_STATE->DEVICE_CONFIG, pid_output / 100.0) != ESP_OK) {
+                // Load changes reach the fan right away instead of through the temperature;
+                // the input power follows frequency and voltage changes within a loop
+                double fan_output = pid_output;
+                float feed_forward = 0;
+                if (fan_feed_forward) {
+                    float load = (power_management->power > 0) ? power_management->power : power_management->frequency_value;
+                    feed_forward = ThermalModel_update(pid_input, load, pid_output, POLL_RATE / 1000.0f);
+                    fan_output = fmin(fmax(pid_output + feed_forward, min_fan_pct), 100);
+                    power_management->thermal_time_constant = ThermalModel_time_constant();
+                }
+
+                power_management->fan_perc = fan_output;
+                if (Thermal_set_fan_percent(&GLOBAL_STATE->DEVICE_CONFIG, fan_output / 100.0) != ESP_OK) {
                     exit(EXIT_FAILURE);
                 }
-                ESP_LOGI(TAG, "Temp: %.1f °C, SetPoint: %.1f °C, Output: %.1f%% (P:%.1f I:%.1f D_val:%.1f D_start_val:%.1f)",
-                         pid_input, pid_setPoint, pid_output, pid.dispKp, pid.dispKi, pid.dispKd, pid_d_startup); // Log current effective Kp, Ki, Kd
+                ESP_LOGI(TAG, "Temp: %.1f °C, SetPoint: %.1f °C, Output: %.1f%% FF: %+.1f%% (P:%.1f I:%.1f D_val:%.1f D_start_val:%.1f)",
+                         pid_input, pid_setPoint, pid_output, feed_forward, pid.dispKp, pid.dispKi, pid.dispKd, pid_d_startup); // Log current effective Kp, Ki, Kd
             } else {
                 if (GLOBAL_STATE->SYSTEM_MODULE.ap_enabled) {
                     ESP_LOGW(TAG, "AP mode with invalid temperature reading: %.1f °C - Setting fan to 70%%", power_management->chip_temp_avg);
@@ -282,8 +391,28 @@ void POWER_MANAGEMENT_task(void * pvParameters)
             }
         }
 
-        uint16_t core_voltage = nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE);
-        float asic_frequency = nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY);
+        uint16_t autotune_mode = nvs_config_get_u16(NVS_CONFIG_AUTOTUNE_MODE);
+        if (autotune_mode != last_autotune_mode) {
+            if (autotune_mode == AUTOTUNE_MODE_OFF) {
+                Autotune_stop(GLOBAL_STATE);
+            } else {
+                Autotune_start(GLOBAL_STATE, autotune_mode);
+            }
+            last_autotune_mode = autotune_mode;
+        }
+
+        // A running sweep overrides the frequency and voltage settings. The
+        // settings are read after the update, which stores the tuned point.
+        uint16_t core_voltage;
+        float asic_frequency;
+        if (Autotune_update(GLOBAL_STATE)) {
+            core_voltage = autotune->voltage;
+            asic_frequency = autotune->frequency;
+            FrequencyGovernor_reset(GLOBAL_STATE);
+        } else {
+            core_voltage = nvs_config_get_u16(NVS_CONFIG_ASIC_VOLTAGE);
+            asic_frequency = FrequencyGovernor_update(GLOBAL_STATE, nvs_config_get_float(NVS_CONFIG_ASIC_FREQUENCY));
+        }
 
         if (core_voltage != last_core_voltage) {
             ESP_LOGI(TAG, "setting new vcore voltage to %umV", core_voltage);
@@ -291,19 +420,20 @@ void POWER_MANAGEMENT_task(void * pvParameters)
             last_core_voltage = core_voltage;
         }
 
-        if (asic_frequency != last_asic_frequency) {
-            ESP_LOGI(TAG, "New ASIC frequency requested: %g MHz (current: %g MHz)", asic_frequency, last_asic_frequency);
-            
-            bool success = ASIC_set_frequency(GLOBAL_STATE, asic_frequency);
-            
-            if (success) {
-                power_management->frequency_value = asic_frequency;
-                power_management->expected_hashrate = expected_hashrate(GLOBAL_STATE, asic_frequency);
-            }
-            
-            last_asic_frequency = asic_frequency;
+        asic_frequency = throttle_frequency(GLOBAL_STATE, asic_frequency,
+                                            fmaxf(power_management->chip_temp_avg, power_management->chip_temp2_avg));
+
+        bool asic_frequency_changed = false;
+        float capped_frequency = PowerCap_update(GLOBAL_STATE, asic_frequency);
+        if (capped_frequency != last_asic_frequency) {
+            ESP_LOGI(TAG, "New ASIC frequency requested: %g MHz (current: %g MHz)", capped_frequency, last_asic_frequency);
+            asic_frequency_changed = set_asic_frequency(GLOBAL_STATE, capped_frequency);
+            last_asic_frequency = capped_frequency;
         }
 
+        ChipFrequency_update(GLOBAL_STATE, asic_frequency_changed);
+        power_management->expected_hashrate = expected_hashrate(GLOBAL_STATE, ChipFrequency_average(GLOBAL_STATE));
+
         // Check for changing of overheat mode
         bool new_overheat_mode = nvs_config_get_bool(NVS_CONFIG_OVERHEAT_MODE);
         
@@ -314,7 +444,21 @@ void POWER_MANAGEMENT_task(void * pvParameters)
 
         VCORE_check_fault(GLOBAL_STATE);
 
+        // The power cap samples faster than the rest of the loop
+        for (int i = 1; i < POLL_RATE / POWER_CAP_POLL_RATE; i++) {
+            vTaskDelay(POWER_CAP_POLL_RATE / portTICK_PERIOD_MS);
+            if (!PowerCap_is_enabled(GLOBAL_STATE)) continue;
+
+            capped_frequency = PowerCap_update(GLOBAL_STATE, asic_frequency);
+            if (capped_frequency != last_asic_frequency) {
+                if (set_asic_frequency(GLOBAL_STATE, capped_frequency)) {
+                    ChipFrequency_update(GLOBAL_STATE, true);
+                }
+                last_asic_frequency = capped_frequency;
+            }
+        }
+
         // looper:
-        vTaskDelay(POLL_RATE / portTICK_PERIOD_MS);
+        vTaskDelay(POWER_CAP_POLL_RATE / portTICK_PERIOD_MS);
     }
 }
@@ -14,6 +14,7 @@ typedef struct
     float expected_hashrate;
     float power;
     float current;
+    float thermal_time_constant; // s, identified by the fan feed-forward, 0 while it is off
 } PowerManagementModule;
 
 void POWER_MANAGEMENT_init_frequency(void * pvParameters);
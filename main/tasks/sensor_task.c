@@ -0,0 +1,93 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "global_state.h"
+#include "power.h"
+#include "power_cap.h"
+#include "thermal.h"
+#include "sensor_task.h"
+
+static const char * TAG = "sensor_task";
+
+// The snapshot is published through two buffers: the task fills the one
+// readers are not pointed at and then advances the published count, whose
+// lowest bit selects the current one. A reader only has to retry when the task
+// started to overwrite the buffer it copied, it never waits for the task.
+static SensorSnapshot snapshots[2];
+static atomic_uint started;
+static atomic_uint published;
+
+static void publish(const SensorSnapshot * snapshot)
+{
+    unsigned int next = atomic_load_explicit(&published, memory_order_relaxed) + 1;
+    atomic_store_explicit(&started, next, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    snapshots[next & 1] = *snapshot;
+    atomic_store_explicit(&published, next, memory_order_release);
+}
+
+bool Sensor_get_snapshot(SensorSnapshot * snapshot)
+{
+    unsigned int current;
+    do {
+        current = atomic_load_explicit(&published, memory_order_acquire);
+        *snapshot = snapshots[current & 1];
+        atomic_thread_fence(memory_order_acquire);
+    } while (atomic_load_explicit(&started, memory_order_relaxed) - current > 1);
+
+    return current != 0 && esp_timer_get_time() - snapshot->timestamp <= SENSOR_STALE_MS * 1000LL;
+}
+
+bool Sensor_power_is_valid(const SensorSnapshot * snapshot)
+{
+    return snapshot->power_timestamp != 0 && esp_timer_get_time() - snapshot->power_timestamp <= SENSOR_STALE_MS * 1000LL;
+}
+
+void SENSOR_task(void * pvParameters)
+{
+    GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
+
+    ESP_LOGI(TAG, "Starting");
+
+    SensorSnapshot snapshot = {0};
+    unsigned long poll_count = 0;
+    bool power_failed = false;
+
+    TickType_t taskWakeTime = xTaskGetTickCount();
+    while (1) {
+        bool slow_poll = poll_count++ % (SENSOR_SLOW_POLL_RATE / SENSOR_POLL_RATE) == 0;
+
+        // Only the power cap needs the power at the fast rate
+        if (slow_poll || PowerCap_is_enabled(GLOBAL_STATE)) {
+            PowerReading reading;
+            esp_err_t err = Power_read(GLOBAL_STATE, &reading);
+            if (err == ESP_OK) {
+                snapshot.voltage = reading.voltage;
+                snapshot.current = reading.current;
+                snapshot.power = reading.power;
+                snapshot.core_voltage = reading.core_voltage;
+                snapshot.vr_temp = reading.vr_temp;
+                snapshot.power_timestamp = esp_timer_get_time();
+            } else if (!power_failed) {
+                // The previous readings stay until they are too old to be used
+                ESP_LOGW(TAG, "Failed to read power: %s", esp_err_to_name(err));
+            }
+            power_failed = err != ESP_OK;
+
+            if (slow_poll) {
+                snapshot.chip_temp = Thermal_get_chip_temp(GLOBAL_STATE);
+                snapshot.chip_temp2 = Thermal_get_chip_temp2(GLOBAL_STATE);
+                snapshot.fan_rpm = Thermal_get_fan_speed(&GLOBAL_STATE->DEVICE_CONFIG);
+                snapshot.fan2_rpm = Thermal_get_fan2_speed(&GLOBAL_STATE->DEVICE_CONFIG);
+            }
+
+            snapshot.timestamp = esp_timer_get_time();
+            publish(&snapshot);
+        }
+
+        vTaskDelayUntil(&taskWakeTime, SENSOR_POLL_RATE / portTICK_PERIOD_MS);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef SENSOR_TASK_H_
+#define SENSOR_TASK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SENSOR_POLL_RATE 300       // ms, power readings while the power cap samples them this often
+#define SENSOR_SLOW_POLL_RATE 1800 // ms, everything
+#define SENSOR_STALE_MS 5000       // a snapshot this old means the sensor task is stuck
+
+typedef struct
+{
+    int64_t timestamp;    // us since boot
+    // us since boot of the last power reading that succeeded, 0 before the first
+    int64_t power_timestamp;
+    float voltage;        // mV input
+    float current;        // mA
+    float power;          // W
+    int16_t core_voltage; // mV
+    float vr_temp;
+    float chip_temp;      // -1 while the ASIC is not initialized
+    float chip_temp2;
+    uint16_t fan_rpm;
+    uint16_t fan2_rpm;
+} SensorSnapshot;
+
+// Copies the latest snapshot without locking. False when there is none or it
+// is older than SENSOR_STALE_MS, the snapshot is copied either way.
+bool Sensor_get_snapshot(SensorSnapshot * snapshot);
+
+// False when the power readings of a snapshot are missing or older than
+// SENSOR_STALE_MS, they keep their last values while the regulator fails
+bool Sensor_power_is_valid(const SensorSnapshot * snapshot);
+
+// Reads every sensor once per period and publishes the readings as a snapshot,
+// so no other task blocks on the I2C bus to read them
+void SENSOR_task(void * pvParameters);
+
+#endif /* SENSOR_TASK_H_ */
@@ -1,38 +1,444 @@
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
 #include <pthread.h>
+#include <sys/param.h>
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
 #include <esp_heap_caps.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "statistics_task.h"
 #include "global_state.h"
 #include "nvs_config.h"
-#include "power.h"
 #include "connect.h"
-#include "vcore.h"
+#include "sensor_task.h"
 #include "bm1370.h"
 
 #define DEFAULT_POLL_RATE 5000
 
 static const char * TAG = "statistics_task";
 
-static StatisticsDataPtr statisticsBuffer;
-static uint16_t statisticsDataStart;
-static uint16_t statisticsDataSize;
+// Samples are stored per resolution in a ring of compressed blocks, see
+// statistics_codec.h. Each column is quantized to a fixed precision first. The
+// blocks take the memory of the former 720 raw rows (48 KiB).
+// Rows with hashrate detail carry STATS_COLUMN_COUNT plus the per ASIC and per
+// domain columns, a block only holds rows of one layout.
+#define STATS_RAW_BLOCKS 13
+#define STATS_1M_BLOCKS 22
+#define STATS_10M_BLOCKS 12
+#define STATS_BLOCK_COUNT (STATS_RAW_BLOCKS + STATS_1M_BLOCKS + STATS_10M_BLOCKS)
+
+// Flash log: blocks are appended to the stats partition whenever they changed,
+// at most every flush_ms for the block that is still being filled. Sectors are
+// reused round robin, live blocks in a sector are written again before it is erased.
+#define STATS_LOG_PARTITION_LABEL "stats"
+#define STATS_LOG_PARTITION_SUBTYPE 0x40
+#define STATS_LOG_MAGIC 0x5354
+#define STATS_LOG_VERSION 2
+#define STATS_LOG_SECTOR_SIZE 4096
+#define STATS_LOG_SLOTS_PER_SECTOR (STATS_LOG_SECTOR_SIZE / sizeof(StatisticsLogSlot))
+#define STATS_LOG_NO_SLOT UINT16_MAX
+// Restored history is rebased so the newest row is 10 days into the timeline
+#define STATS_LOG_TIME_BASE_MS (10 * 24 * 60 * 60 * 1000UL)
+
+typedef struct
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t resolution;
+    uint32_t write_count;
+    uint32_t time_shift; // seconds the timestamps were rebased by since the log started
+    uint32_t crc;
+} StatisticsLogHeader;
+
+typedef struct
+{
+    StatisticsLogHeader header;
+    StatisticsBlock block;
+} StatisticsLogSlot;
+
+_Static_assert(sizeof(StatisticsLogSlot) == 1024, "Statistics log slot must be 1 KiB");
+
+// Newest flash copy of a block
+typedef struct
+{
+    uint32_t sequence; // block the copy belongs to
+    uint16_t slot;
+    uint16_t rows;
+    uint32_t write_count;
+} StatisticsLogState;
+
+typedef struct
+{
+    StatisticsRing ring;
+    const uint32_t flush_ms;
+    StatisticsLogState * log;
+    uint32_t last_flush;
+} StatisticsTier;
+
+static StatisticsTier statisticsTiers[STATS_RESOLUTION_COUNT] = {
+    [STATS_RESOLUTION_RAW] = {.ring = {.window_ms = 0, .block_count = STATS_RAW_BLOCKS}, .flush_ms = 60 * 1000},
+    [STATS_RESOLUTION_1M] = {.ring = {.window_ms = 60 * 1000, .block_count = STATS_1M_BLOCKS}, .flush_ms = 10 * 60 * 1000},
+    [STATS_RESOLUTION_10M] = {.ring = {.window_ms = 10 * 60 * 1000, .block_count = STATS_10M_BLOCKS}, .flush_ms = 10 * 60 * 1000},
+};
+
+static StatisticsLogState statisticsLogStates[STATS_BLOCK_COUNT];
+static const esp_partition_t * statisticsLog;
+static StatisticsLogSlot * statisticsLogSlot;
+static uint16_t statisticsLogSlotCount;
+static uint16_t statisticsLogNextSlot;
+static uint32_t statisticsLogWriteCount;
+static bool statisticsLogRestored;
+static uint32_t statisticsTimeShift;
+// Added to the uptime so timestamps continue the restored history
+static uint32_t statisticsTimeOffset;
+
+typedef enum
+{
+    COLUMN_FLOAT,
+    COLUMN_INT16,
+    COLUMN_UINT16,
+    COLUMN_INT8,
+    COLUMN_UINT32,
+} StatisticsColumnType;
+
+typedef struct
+{
+    size_t offset;
+    StatisticsColumnType type;
+    float scale; // stored value = value * scale
+} StatisticsColumn;
+
+static const StatisticsColumn statisticsColumns[STATS_COLUMN_COUNT] = {
+    {offsetof(struct StatisticsData, hashrate), COLUMN_FLOAT, 1.0f},          // 1 GH/s
+    {offsetof(struct StatisticsData, hashrate_1m), COLUMN_FLOAT, 1.0f},
+    {offsetof(struct StatisticsData, hashrate_10m), COLUMN_FLOAT, 1.0f},
+    {offsetof(struct StatisticsData, hashrate_1h), COLUMN_FLOAT, 1.0f},
+    {offsetof(struct StatisticsData, errorPercentage), COLUMN_FLOAT, 100.0f}, // 0.01 %
+    {offsetof(struct StatisticsData, chipTemperature), COLUMN_FLOAT, 10.0f},  // 0.1 °C
+    {offsetof(struct StatisticsData, vrTemperature), COLUMN_FLOAT, 10.0f},
+    {offsetof(struct StatisticsData, power), COLUMN_FLOAT, 20.0f},            // 50 mW
+    {offsetof(struct StatisticsData, voltage), COLUMN_FLOAT, 1.0f},           // 1 mV
+    {offsetof(struct StatisticsData, current), COLUMN_FLOAT, 0.1f},           // 10 mA
+    {offsetof(struct StatisticsData, coreVoltageActual), COLUMN_INT16, 1.0f},
+    {offsetof(struct StatisticsData, fanSpeed), COLUMN_FLOAT, 10.0f},         // 0.1 %
+    {offsetof(struct StatisticsData, fanRPM), COLUMN_UINT16, 1.0f},
+    {offsetof(struct StatisticsData, fan2RPM), COLUMN_UINT16, 1.0f},
+    {offsetof(struct StatisticsData, wifiRSSI), COLUMN_INT8, 1.0f},
+    {offsetof(struct StatisticsData, freeHeap), COLUMN_UINT32, 1.0f / 256},   // 256 bytes
+    {offsetof(struct StatisticsData, responseTime), COLUMN_FLOAT, 1.0f},      // 1 ms
+};
+
 static pthread_mutex_t statisticsDataLock = PTHREAD_MUTEX_INITIALIZER;
 
-static const uint16_t maxDataCount = 720;
+static int32_t quantizeColumn(const StatisticsColumn * column, const struct StatisticsData * data)
+{
+    const void * field = (const uint8_t *)data + column->offset;
+    double value;
+    switch (column->type) {
+        case COLUMN_FLOAT:  value = *(const float *)field; break;
+        case COLUMN_INT16:  value = *(const int16_t *)field; break;
+        case COLUMN_UINT16: value = *(const uint16_t *)field; break;
+        case COLUMN_INT8:   value = *(const int8_t *)field; break;
+        case COLUMN_UINT32: value = *(const uint32_t *)field; break;
+        default:            value = 0; break;
+    }
+    value = round(value * column->scale);
+    if (isnan(value)) return 0;
+    if (value > INT32_MAX) return INT32_MAX;
+    if (value < INT32_MIN) return INT32_MIN;
+    return (int32_t)value;
+}
+
+static void restoreColumn(const StatisticsColumn * column, int32_t stored, struct StatisticsData * data)
+{
+    void * field = (uint8_t *)data + column->offset;
+    double value = stored / (double)column->scale;
+    switch (column->type) {
+        case COLUMN_FLOAT:  *(float *)field = value; break;
+        case COLUMN_INT16:  *(int16_t *)field = value; break;
+        case COLUMN_UINT16: *(uint16_t *)field = value; break;
+        case COLUMN_INT8:   *(int8_t *)field = value; break;
+        case COLUMN_UINT32: *(uint32_t *)field = value; break;
+    }
+}
+
+// True when the newest flash copy holds every row of the block
+static bool isLogged(const StatisticsLogState * state, const StatisticsBlock * block)
+{
+    return state->slot != STATS_LOG_NO_SLOT && state->sequence == block->sequence && state->rows == block->rows;
+}
+
+static void prepareStatisticsLogSector(void)
+{
+    uint16_t first = statisticsLogNextSlot;
+
+    // Blocks whose newest copy is in this sector are written again
+    for (int i = 0; i < STATS_BLOCK_COUNT; i++) {
+        StatisticsLogState * state = &statisticsLogStates[i];
+        if (state->slot != STATS_LOG_NO_SLOT && state->slot >= first && state->slot < first + STATS_LOG_SLOTS_PER_SECTOR) {
+            state->slot = STATS_LOG_NO_SLOT;
+        }
+    }
+
+    esp_err_t err = esp_partition_erase_range(statisticsLog, (size_t)first * sizeof(StatisticsLogSlot), STATS_LOG_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Statistics log erase failed: %s", esp_err_to_name(err));
+    }
+}
+
+static bool writeStatisticsLogSlot(StatisticsTier * tier, StatisticsResolution resolution, uint32_t sequence)
+{
+    if (statisticsLogNextSlot % STATS_LOG_SLOTS_PER_SECTOR == 0) {
+        prepareStatisticsLogSector();
+    }
+
+    uint16_t index = (sequence - 1) % tier->ring.block_count;
+
+    pthread_mutex_lock(&statisticsDataLock);
+    bool live = tier->ring.blocks != NULL && tier->ring.blocks[index].sequence == sequence;
+    if (live) {
+        statisticsLogSlot->block = tier->ring.blocks[index];
+    }
+    pthread_mutex_unlock(&statisticsDataLock);
+
+    if (!live) {
+        return false;
+    }
+
+    statisticsLogSlot->header = (StatisticsLogHeader){
+        .magic = STATS_LOG_MAGIC,
+        .version = STATS_LOG_VERSION,
+        .resolution = resolution,
+        .write_count = statisticsLogWriteCount + 1,
+        .time_shift = statisticsTimeShift,
+        .crc = 0,
+    };
+    statisticsLogSlot->header.crc = esp_rom_crc32_le(0, (const uint8_t *)statisticsLogSlot, sizeof(StatisticsLogSlot));
+
+    uint16_t slot = statisticsLogNextSlot;
+    statisticsLogNextSlot = (slot + 1) % statisticsLogSlotCount;
+
+    esp_err_t err = esp_partition_write(statisticsLog, (size_t)slot * sizeof(StatisticsLogSlot), statisticsLogSlot, sizeof(StatisticsLogSlot));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Statistics log write failed: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    statisticsLogWriteCount++;
+    tier->log[index] = (StatisticsLogState){
+        .sequence = sequence,
+        .slot = slot,
+        .rows = statisticsLogSlot->block.rows,
+        .write_count = statisticsLogWriteCount,
+    };
+    return true;
+}
+
+static void flushStatisticsLog(uint32_t now)
+{
+    if (NULL == statisticsLog || NULL == statisticsTiers[0].ring.blocks) {
+        return;
+    }
+
+    // Bounded, relocating a sector can make a few more blocks dirty
+    for (int writes = 0; writes < 2 * STATS_BLOCK_COUNT; writes++) {
+        StatisticsTier * dirtyTier = NULL;
+        StatisticsResolution dirtyResolution = STATS_RESOLUTION_RAW;
+        uint32_t dirtySequence = 0;
+
+        for (int r = 0; r < STATS_RESOLUTION_COUNT && dirtyTier == NULL; r++) {
+            StatisticsTier * tier = &statisticsTiers[r];
+            StatisticsRing * ring = &tier->ring;
+
+            for (uint32_t sequence = statistics_ring_oldest(ring); sequence < ring->next_sequence; sequence++) {
+                uint16_t index = (sequence - 1) % ring->block_count;
+                const StatisticsBlock * block = &ring->blocks[index];
+                const StatisticsLogState * state = &tier->log[index];
+
+                if (block->sequence != sequence || block->rows == 0) continue;
+                if (isLogged(state, block)) continue;
+                // The block that is still being filled is only written every flush_ms
+                if (ring->open && sequence == ring->next_sequence - 1 && state->slot != STATS_LOG_NO_SLOT &&
+                    state->sequence == sequence && now - tier->last_flush < tier->flush_ms) continue;
+
+                dirtyTier = tier;
+                dirtyResolution = r;
+                dirtySequence = sequence;
+                break;
+            }
+        }
+
+        if (dirtyTier == NULL) {
+            break;
+        }
+
+        if (dirtySequence == dirtyTier->ring.next_sequence - 1) {
+            dirtyTier->last_flush = now;
+        }
+
+        if (!writeStatisticsLogSlot(dirtyTier, dirtyResolution, dirtySequence)) {
+            break;
+        }
+    }
+}
+
+static bool readStatisticsLogSlot(uint16_t slot)
+{
+    if (esp_partition_read(statisticsLog, (size_t)slot * sizeof(StatisticsLogSlot), statisticsLogSlot, sizeof(StatisticsLogSlot)) != ESP_OK) {
+        return false;
+    }
+
+    StatisticsLogHeader * header = &statisticsLogSlot->header;
+    if (header->magic != STATS_LOG_MAGIC || header->version != STATS_LOG_VERSION || header->resolution >= STATS_RESOLUTION_COUNT) {
+        return false;
+    }
+
+    uint32_t crc = header->crc;
+    header->crc = 0;
+    return crc == esp_rom_crc32_le(0, (const uint8_t *)statisticsLogSlot, sizeof(StatisticsLogSlot));
+}
+
+// Timestamp on the continuous timeline of the log, in ms
+static uint64_t globalTimestamp(uint32_t timestamp, uint32_t time_shift)
+{
+    return (uint64_t)time_shift * 1000 + timestamp;
+}
+
+// Loads the blocks of earlier boots, called with the buffers allocated and statisticsDataLock held
+static void restoreStatisticsLog(void)
+{
+    statisticsLog = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)STATS_LOG_PARTITION_SUBTYPE, STATS_LOG_PARTITION_LABEL);
+    if (NULL == statisticsLog) {
+        ESP_LOGW(TAG, "No statistics partition, history is not persisted");
+        return;
+    }
+
+    statisticsLogSlotCount = (statisticsLog->size / STATS_LOG_SECTOR_SIZE) * STATS_LOG_SLOTS_PER_SECTOR;
+    if (statisticsLogSlotCount <= STATS_BLOCK_COUNT + STATS_LOG_SLOTS_PER_SECTOR) {
+        ESP_LOGE(TAG, "Statistics partition too small");
+        statisticsLog = NULL;
+        return;
+    }
+
+    // First pass: newest write and newest timestamp
+    uint64_t newest = 0;
+    int newestSlot = -1;
+    uint32_t newestWriteCount = 0;
+    for (uint16_t slot = 0; slot < statisticsLogSlotCount; slot++) {
+        if (!readStatisticsLogSlot(slot)) continue;
+        const StatisticsLogSlot * logSlot = statisticsLogSlot;
+        uint64_t last = globalTimestamp(logSlot->block.last_timestamp, logSlot->header.time_shift);
+        if (last > newest) newest = last;
+        if (newestSlot < 0 || logSlot->header.write_count > newestWriteCount) {
+            newestWriteCount = logSlot->header.write_count;
+            newestSlot = slot;
+        }
+    }
+
+    // The timeline is only rebased on the first restore of a boot, rows of this boot already use it
+    if (!statisticsLogRestored && newest > STATS_LOG_TIME_BASE_MS) {
+        statisticsTimeShift = (newest - STATS_LOG_TIME_BASE_MS) / 1000;
+    }
+    uint64_t shift = (uint64_t)statisticsTimeShift * 1000;
+
+    // Second pass: newest copy of every block that still fits the timeline
+    int restored = 0;
+    for (uint16_t slot = 0; newestSlot >= 0 && slot < statisticsLogSlotCount; slot++) {
+        if (!readStatisticsLogSlot(slot)) continue;
+        const StatisticsLogSlot * logSlot = statisticsLogSlot;
+        StatisticsTier * tier = &statisticsTiers[logSlot->header.resolution];
+
+        uint64_t first = globalTimestamp(logSlot->block.first_timestamp, logSlot->header.time_shift);
+        uint64_t last = globalTimestamp(logSlot->block.last_timestamp, logSlot->header.time_shift);
+        if (logSlot->block.sequence == 0 || first < shift || last - shift > UINT32_MAX) continue;
+        if (logSlot->block.layout.asic_count > STATS_MAX_ASICS || logSlot->block.layout.hash_domains > STATS_MAX_DOMAINS) continue;
+
+        uint16_t index = (logSlot->block.sequence - 1) % tier->ring.block_count;
+        StatisticsBlock * block = &tier->ring.blocks[index];
+        StatisticsLogState * state = &tier->log[index];
+        if (block->sequence > logSlot->block.sequence ||
+            (block->sequence == logSlot->block.sequence && state->write_count > logSlot->header.write_count)) {
+            continue;
+        }
+
+        if (block->sequence == 0) restored++;
+        *block = logSlot->block;
+        block->first_timestamp = first - shift;
+        block->last_timestamp = last - shift;
+        // The copy keeps its own time_shift, so it stays valid after rebasing
+        *state = (StatisticsLogState){
+            .sequence = block->sequence,
+            .slot = slot,
+            .rows = block->rows,
+            .write_count = logSlot->header.write_count,
+        };
+    }
+
+    uint32_t newestTimestamp = 0;
+    for (int r = 0; r < STATS_RESOLUTION_COUNT; r++) {
+        StatisticsTier * tier = &statisticsTiers[r];
+        StatisticsRing * ring = &tier->ring;
+        uint32_t newestSequence = 0;
+        for (int i = 0; i < ring->block_count; i++) {
+            if (ring->blocks[i].sequence > newestSequence) newestSequence = ring->blocks[i].sequence;
+        }
+        // Drop blocks that were already evicted before the newer ones were written
+        for (int i = 0; i < ring->block_count; i++) {
+            if (ring->blocks[i].sequence != 0 && ring->blocks[i].sequence + ring->block_count <= newestSequence) {
+                memset(&ring->blocks[i], 0, sizeof(StatisticsBlock));
+                tier->log[i] = (StatisticsLogState){.slot = STATS_LOG_NO_SLOT};
+            } else if (ring->blocks[i].sequence != 0 && ring->blocks[i].last_timestamp > newestTimestamp) {
+                newestTimestamp = ring->blocks[i].last_timestamp;
+            }
+        }
+        ring->next_sequence = newestSequence + 1;
+        ring->open = false;
+    }
+
+    if (!statisticsLogRestored && restored > 0) {
+        statisticsTimeOffset = newestTimestamp + 1;
+    }
+    statisticsLogRestored = true;
+
+    // Continue in a fresh sector after the newest write
+    statisticsLogWriteCount = newestWriteCount;
+    statisticsLogNextSlot = newestSlot < 0 ? 0 :
+        ((newestSlot / STATS_LOG_SLOTS_PER_SECTOR + 1) * STATS_LOG_SLOTS_PER_SECTOR) % statisticsLogSlotCount;
+
+    ESP_LOGI(TAG, "Restored %d statistics blocks from flash", restored);
+}
 
 void createStatisticsBuffer()
 {
-    if (NULL == statisticsBuffer) {
+    if (NULL == statisticsTiers[0].ring.blocks) {
         pthread_mutex_lock(&statisticsDataLock);
 
-        if (NULL == statisticsBuffer) {
-            statisticsBuffer = (StatisticsDataPtr)heap_caps_malloc(sizeof(struct StatisticsData) * maxDataCount, MALLOC_CAP_SPIRAM);
-            if (NULL == statisticsBuffer) {
+        if (NULL == statisticsTiers[0].ring.blocks) {
+            StatisticsBlock * blocks = heap_caps_calloc(STATS_BLOCK_COUNT, sizeof(StatisticsBlock), MALLOC_CAP_SPIRAM);
+            statisticsLogSlot = heap_caps_malloc(sizeof(StatisticsLogSlot), MALLOC_CAP_SPIRAM);
+            if (NULL == blocks || NULL == statisticsLogSlot) {
                 ESP_LOGW(TAG, "Not enough memory for the statistics data buffer!");
+                heap_caps_free(blocks);
+                heap_caps_free(statisticsLogSlot);
+                statisticsLogSlot = NULL;
+            } else {
+                StatisticsLogState * log = statisticsLogStates;
+                for (int i = 0; i < STATS_RESOLUTION_COUNT; i++) {
+                    statistics_ring_init(&statisticsTiers[i].ring, blocks);
+                    statisticsTiers[i].log = log;
+                    blocks += statisticsTiers[i].ring.block_count;
+                    log += statisticsTiers[i].ring.block_count;
+                }
+                for (int i = 0; i < STATS_BLOCK_COUNT; i++) {
+                    statisticsLogStates[i] = (StatisticsLogState){.slot = STATS_LOG_NO_SLOT};
+                }
+
+                restoreStatisticsLog();
             }
         }
 
@@ -42,21 +448,34 @@ void createStatisticsBuffer()
 
 void removeStatisticsBuffer()
 {
-    if (NULL != statisticsBuffer) {
+    if (NULL != statisticsTiers[0].ring.blocks) {
         pthread_mutex_lock(&statisticsDataLock);
 
-        if (NULL != statisticsBuffer) {
-            heap_caps_free(statisticsBuffer);
+        if (NULL != statisticsTiers[0].ring.blocks) {
+            heap_caps_free(statisticsTiers[0].ring.blocks);
+            heap_caps_free(statisticsLogSlot);
+            statisticsLogSlot = NULL;
+            statisticsLog = NULL;
 
-            statisticsBuffer = NULL;
-            statisticsDataStart = 0;
-            statisticsDataSize = 0;
+            for (int i = 0; i < STATS_RESOLUTION_COUNT; i++) {
+                statisticsTiers[i].ring.blocks = NULL;
+            }
         }
 
         pthread_mutex_unlock(&statisticsDataLock);
     }
 }
 
+uint32_t getStatisticsTime(void)
+{
+    return statisticsTimeOffset + esp_timer_get_time() / 1000;
+}
+
+uint32_t getStatisticsBootTime(void)
+{
+    return statisticsTimeOffset;
+}
+
 bool addStatisticData(StatisticsDataPtr data)
 {
     bool result = false;
@@ -67,19 +486,32 @@ bool addStatisticData(StatisticsDataPtr data)
 
     createStatisticsBuffer();
 
-    pthread_mutex_lock(&statisticsDataLock);
-
-    if (NULL != statisticsBuffer) {
-        statisticsDataSize++;
+    StatisticsLayout layout = {
+        .asic_count = MIN(data->asicCount, STATS_MAX_ASICS),
+        .hash_domains = data->asicCount > 0 ? MIN(data->hashDomains, STATS_MAX_DOMAINS) : 0,
+    };
 
-        if (maxDataCount < statisticsDataSize) {
-            statisticsDataSize = maxDataCount;
-            statisticsDataStart++;
-            statisticsDataStart = statisticsDataStart % maxDataCount;
+    int32_t values[STATS_MAX_COLUMN_COUNT];
+    int column = 0;
+    for (; column < STATS_COLUMN_COUNT; column++) {
+        values[column] = quantizeColumn(&statisticsColumns[column], data);
+    }
+    // Detail columns are already 0.1 GH/s integers
+    for (int asic = 0; asic < layout.asic_count; asic++) {
+        values[column++] = data->asicHashrate[asic];
+    }
+    for (int asic = 0; asic < layout.asic_count; asic++) {
+        for (int domain = 0; domain < layout.hash_domains; domain++) {
+            values[column++] = data->domainHashrate[asic][domain];
         }
+    }
 
-        const uint16_t last = (statisticsDataStart + statisticsDataSize - 1) % maxDataCount;
-        statisticsBuffer[last] = *data;
+    pthread_mutex_lock(&statisticsDataLock);
+
+    if (NULL != statisticsTiers[0].ring.blocks) {
+        for (int i = 0; i < STATS_RESOLUTION_COUNT; i++) {
+            statistics_ring_add(&statisticsTiers[i].ring, data->timestamp, layout, values);
+        }
         result = true;
     }
 
@@ -88,19 +520,42 @@ bool addStatisticData(StatisticsDataPtr data)
     return result;
 }
 
-bool getStatisticData(uint16_t index, StatisticsDataPtr dataOut)
+void initStatisticIterator(StatisticsIterator * iterator, StatisticsResolution resolution, uint32_t since)
+{
+    iterator->resolution = resolution < STATS_RESOLUTION_COUNT ? resolution : STATS_RESOLUTION_RAW;
+    statistics_cursor_init(&iterator->cursor, since);
+}
+
+bool nextStatisticData(StatisticsIterator * iterator, StatisticsDataPtr dataOut)
 {
     bool result = false;
 
-    if ((NULL == statisticsBuffer) || (NULL == dataOut) || (maxDataCount <= index)) {
+    if (NULL == iterator || NULL == dataOut) {
         return result;
     }
 
     pthread_mutex_lock(&statisticsDataLock);
 
-    if ((NULL != statisticsBuffer) && (index < statisticsDataSize)) {
-        index = (statisticsDataStart + index) % maxDataCount;
-        *dataOut = statisticsBuffer[index];
+    const StatisticsRing * ring = &statisticsTiers[iterator->resolution].ring;
+    StatisticsCursor * cursor = &iterator->cursor;
+    StatisticsLayout layout;
+
+    if (NULL != ring->blocks && statistics_cursor_next(cursor, ring, &layout)) {
+        dataOut->timestamp = cursor->timestamp;
+        int column = 0;
+        for (; column < STATS_COLUMN_COUNT; column++) {
+            restoreColumn(&statisticsColumns[column], cursor->values[column], dataOut);
+        }
+        dataOut->asicCount = layout.asic_count;
+        dataOut->hashDomains = layout.hash_domains;
+        for (int asic = 0; asic < layout.asic_count; asic++) {
+            dataOut->asicHashrate[asic] = cursor->values[column++];
+        }
+        for (int asic = 0; asic < layout.asic_count; asic++) {
+            for (int domain = 0; domain < layout.hash_domains; domain++) {
+                dataOut->domainHashrate[asic][domain] = cursor->values[column++];
+            }
+        }
         result = true;
     }
 
@@ -109,6 +564,22 @@ bool getStatisticData(uint16_t index, StatisticsDataPtr dataOut)
     return result;
 }
 
+StatisticsResolution strToStatisticsResolution(const char * resolutionStr)
+{
+    if (NULL != resolutionStr) {
+        if (strcmp(resolutionStr, "1m") == 0)  return STATS_RESOLUTION_1M;
+        if (strcmp(resolutionStr, "10m") == 0) return STATS_RESOLUTION_10M;
+    }
+    return STATS_RESOLUTION_RAW;
+}
+
+static uint16_t hashrateToDeciGhs(float hashrate)
+{
+    if (isnan(hashrate) || hashrate <= 0) return 0;
+    if (hashrate >= UINT16_MAX / 10.0f) return UINT16_MAX;
+    return lroundf(hashrate * 10.0f);
+}
+
 void statistics_task(void * pvParameters)
 {
     ESP_LOGI(TAG, "Starting");
@@ -116,22 +587,28 @@ void statistics_task(void * pvParameters)
     GlobalState * GLOBAL_STATE = (GlobalState *) pvParameters;
     SystemModule * sys_module = &GLOBAL_STATE->SYSTEM_MODULE;
     PowerManagementModule * power_management = &GLOBAL_STATE->POWER_MANAGEMENT_MODULE;
+    HashrateMonitorModule * hashrate_monitor = &GLOBAL_STATE->HASHRATE_MONITOR_MODULE;
     struct StatisticsData statsData = {};
 
     TickType_t taskWakeTime = xTaskGetTickCount();
 
     while (1) {
-        const int32_t currentTime = esp_timer_get_time() / 1000;
         const uint16_t configStatsFrequency = nvs_config_get_u16(NVS_CONFIG_STATISTICS_FREQUENCY);
         const uint32_t statsFrequency = configStatsFrequency * 1000;
 
         if (0 != statsFrequency) {
-            const int32_t waitingTime = statsData.timestamp + statsFrequency - (DEFAULT_POLL_RATE / 2);
+            // Restores the history and its timeline before the first sample
+            createStatisticsBuffer();
+
+            const uint32_t currentTime = getStatisticsTime();
 
-            if (currentTime > waitingTime) {
+            if (0 == statsData.timestamp || (int32_t)(currentTime - statsData.timestamp) > (int32_t)statsFrequency - (DEFAULT_POLL_RATE / 2)) {
                 int8_t wifiRSSI = -90;
                 get_wifi_current_rssi(&wifiRSSI);
 
+                SensorSnapshot sensors;
+                Sensor_get_snapshot(&sensors);
+
                 statsData.timestamp = currentTime;
                 statsData.hashrate = sys_module->current_hashrate;
                 statsData.hashrate_1m = sys_module->hashrate_1m;
@@ -142,8 +619,8 @@ void statistics_task(void * pvParameters)
                 statsData.vrTemperature = power_management->vr_temp;
                 statsData.power = power_management->power;
                 statsData.voltage = power_management->voltage;
-                statsData.current = Power_get_current(GLOBAL_STATE);
-                statsData.coreVoltageActual = VCORE_get_voltage_mv(GLOBAL_STATE);
+                statsData.current = sensors.current;
+                statsData.coreVoltageActual = sensors.core_voltage;
                 statsData.fanSpeed = power_management->fan_perc;
                 statsData.fanRPM = power_management->fan_rpm;
                 statsData.fan2RPM = power_management->fan2_rpm;
@@ -151,8 +628,23 @@ void statistics_task(void * pvParameters)
                 statsData.freeHeap = esp_get_free_heap_size();
                 statsData.responseTime = sys_module->response_time;
 
+                statsData.asicCount = 0;
+                statsData.hashDomains = 0;
+                if (nvs_config_get_bool(NVS_CONFIG_STATISTICS_HASHRATE_DETAIL) && hashrate_monitor->is_initialized) {
+                    statsData.asicCount = MIN(GLOBAL_STATE->DEVICE_CONFIG.family.asic_count, STATS_MAX_ASICS);
+                    statsData.hashDomains = MIN(GLOBAL_STATE->DEVICE_CONFIG.family.asic.hash_domains, STATS_MAX_DOMAINS);
+                    for (int asic = 0; asic < statsData.asicCount; asic++) {
+                        statsData.asicHashrate[asic] = hashrateToDeciGhs(hashrate_monitor->total_measurement[asic].hashrate);
+                        for (int domain = 0; domain < statsData.hashDomains; domain++) {
+                            statsData.domainHashrate[asic][domain] = hashrateToDeciGhs(hashrate_monitor->domain_measurements[asic][domain].hashrate);
+                        }
+                    }
+                }
+
                 addStatisticData(&statsData);
             }
+
+            flushStatisticsLog(currentTime);
         } else {
             removeStatisticsBuffer();
         }
@@ -1,6 +1,10 @@
 #ifndef STATISTICS_TASK_H_
 #define STATISTICS_TASK_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "statistics_codec.h"
+
 typedef struct StatisticsData * StatisticsDataPtr;
 
 struct StatisticsData
@@ -23,9 +27,38 @@ struct StatisticsData
     int8_t wifiRSSI;
     uint32_t freeHeap;
     float responseTime;
+    uint8_t asicCount;   // 0 when the row has no detail columns
+    uint8_t hashDomains;
+    uint16_t asicHashrate[STATS_MAX_ASICS];                       // 0.1 GH/s
+    uint16_t domainHashrate[STATS_MAX_ASICS][STATS_MAX_DOMAINS];  // 0.1 GH/s
 };
 
-bool getStatisticData(uint16_t index, StatisticsDataPtr dataOut);
+// Retention without detail columns. Rows with statsHashrateDetail take more
+// space, about half the time on a single ASIC board and a seventh with 8 ASICs.
+typedef enum
+{
+    STATS_RESOLUTION_RAW,  // every sample, about 1 hour at 5 s sampling
+    STATS_RESOLUTION_1M,   // 1 minute averages, about 24 hours
+    STATS_RESOLUTION_10M,  // 10 minute averages, about 7 days
+    STATS_RESOLUTION_COUNT // last
+} StatisticsResolution;
+
+// Walks the rows of one resolution from oldest to newest. Safe to use while
+// new samples arrive; rows evicted in between are skipped.
+typedef struct
+{
+    StatisticsResolution resolution;
+    StatisticsCursor cursor;
+} StatisticsIterator;
+
+void initStatisticIterator(StatisticsIterator * iterator, StatisticsResolution resolution, uint32_t since);
+bool nextStatisticData(StatisticsIterator * iterator, StatisticsDataPtr dataOut);
+StatisticsResolution strToStatisticsResolution(const char * resolutionStr);
+
+// Statistics timestamps continue the history restored from flash: uptime in ms plus the offset
+uint32_t getStatisticsTime(void);
+// Timestamp at which this boot started
+uint32_t getStatisticsBootTime(void);
 
 void statistics_task(void * pvParameters);
 
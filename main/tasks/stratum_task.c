@@ -58,6 +58,11 @@ struct timeval tcp_rcv_timeout = {
 static uint16_t primary_stratum_tls;
 static char * primary_stratum_cert;
 
+static char last_prev_block_hash[HASH_SIZE * 2 + 1];
+
+// One transport per pool, reused across reconnects so the TLS session cache stays warm
+static esp_transport_handle_t pool_transports[STRATUM_POOL_COUNT];
+
 typedef struct {
     struct sockaddr_storage dest_addr;  // Stores IPv4 or IPv6 address with scope_id for IPv6
     socklen_t addrlen;
@@ -180,6 +185,14 @@ void cleanQueue(GlobalState * GLOBAL_STATE) {
         GLOBAL_STATE->valid_jobs[i] = 0;
     }
     pthread_mutex_unlock(&GLOBAL_STATE->valid_jobs_lock);
+
+    // Bumped after the queues are cleared, so only newer notifies carry the new epoch
+    GLOBAL_STATE->prevhash_epoch++;
+
+    // Wake the ASIC task so it picks up fresh work instead of waiting out the job interval
+    if (GLOBAL_STATE->ASIC_TASK_MODULE.semaphore != NULL) {
+        xSemaphoreGive(GLOBAL_STATE->ASIC_TASK_MODULE.semaphore);
+    }
 }
 
 void stratum_reset_uid(GlobalState * GLOBAL_STATE)
@@ -227,7 +240,7 @@ void stratum_primary_heartbeat(void * pvParameters)
        
         tls_mode tls = GLOBAL_STATE->SYSTEM_MODULE.pool_tls;
         char * cert = GLOBAL_STATE->SYSTEM_MODULE.pool_cert;
-        esp_transport_handle_t transport = STRATUM_V1_transport_init(tls, cert);
+        esp_transport_handle_t transport = STRATUM_V1_transport_init(tls, cert, STRATUM_POOL_PRIMARY);
         if (transport == NULL) {
             ESP_LOGD(TAG, "Heartbeat. Failed transport init check!");
             vTaskDelay(60000 / portTICK_PERIOD_MS);
@@ -239,6 +252,7 @@ void stratum_primary_heartbeat(void * pvParameters)
         {
             ESP_LOGD(TAG, "Heartbeat. Failed connect check: %s:%d (errno %d: %s)", primary_stratum_url, primary_stratum_port, err, strerror(err));
             esp_transport_close(transport);
+            esp_transport_destroy(transport);
             vTaskDelay(60000 / portTICK_PERIOD_MS);
             continue;
         }
@@ -252,6 +266,7 @@ void stratum_primary_heartbeat(void * pvParameters)
         int bytes_received = esp_transport_read(transport, recv_buffer, BUFFER_SIZE - 1, TRANSPORT_TIMEOUT_MS); 
 
         esp_transport_close(transport);
+        esp_transport_destroy(transport);
 
         if (bytes_received == -1)  {
             vTaskDelay(60000 / portTICK_PERIOD_MS);
@@ -393,6 +408,7 @@ void stratum_task(void * pvParameters)
             GLOBAL_STATE->SYSTEM_MODULE.rejected_reason_stats_count = 0;
             GLOBAL_STATE->SYSTEM_MODULE.shares_accepted = 0;
             GLOBAL_STATE->SYSTEM_MODULE.shares_rejected = 0;
+            GLOBAL_STATE->SYSTEM_MODULE.shares_stale_avoided = 0;
             GLOBAL_STATE->SYSTEM_MODULE.work_received = 0;
 
             ESP_LOGI(TAG, "Switching target due to too many failures (retries: %d)...", retry_attempts);
@@ -418,7 +434,11 @@ void stratum_task(void * pvParameters)
         cert = GLOBAL_STATE->SYSTEM_MODULE.is_using_fallback ? GLOBAL_STATE->SYSTEM_MODULE.fallback_pool_cert : GLOBAL_STATE->SYSTEM_MODULE.pool_cert;
         retry_critical_attempts = 0;
 
-        GLOBAL_STATE->transport = STRATUM_V1_transport_init(tls, cert);
+        stratum_pool pool = GLOBAL_STATE->SYSTEM_MODULE.is_using_fallback ? STRATUM_POOL_FALLBACK : STRATUM_POOL_PRIMARY;
+        if (pool_transports[pool] == NULL) {
+            pool_transports[pool] = STRATUM_V1_transport_init(tls, cert, pool);
+        }
+        GLOBAL_STATE->transport = pool_transports[pool];
         // Check if transport was initialized
         if(GLOBAL_STATE->transport == NULL) {
             ESP_LOGE(TAG, "Transport initialization failed.");
@@ -500,14 +520,21 @@ void stratum_task(void * pvParameters)
             if (stratum_api_v1_message.method == MINING_NOTIFY) {
                 GLOBAL_STATE->SYSTEM_MODULE.work_received++;
                 SYSTEM_notify_new_ntime(GLOBAL_STATE, stratum_api_v1_message.mining_notification->ntime);
+                bool new_prevhash = strcmp(last_prev_block_hash, stratum_api_v1_message.mining_notification->prev_block_hash) != 0;
                 if (stratum_api_v1_message.should_abandon_work &&
                     (GLOBAL_STATE->stratum_queue.count > 0 || GLOBAL_STATE->ASIC_jobs_queue.count > 0)) {
                     cleanQueue(GLOBAL_STATE);
+                } else if (stratum_api_v1_message.should_abandon_work || new_prevhash) {
+                    GLOBAL_STATE->prevhash_epoch++;
+                }
+                if (new_prevhash) {
+                    strncpy(last_prev_block_hash, stratum_api_v1_message.mining_notification->prev_block_hash, sizeof(last_prev_block_hash) - 1);
                 }
                 if (GLOBAL_STATE->stratum_queue.count == QUEUE_SIZE) {
                     mining_notify * next_notify_json_str = (mining_notify *) queue_dequeue(&GLOBAL_STATE->stratum_queue);
                     STRATUM_V1_free_mining_notify(next_notify_json_str);
                 }
+                stratum_api_v1_message.mining_notification->prevhash_epoch = GLOBAL_STATE->prevhash_epoch;
                 queue_enqueue(&GLOBAL_STATE->stratum_queue, stratum_api_v1_message.mining_notification);
                 decode_mining_notification(GLOBAL_STATE, stratum_api_v1_message.mining_notification);
             } else if (stratum_api_v1_message.method == MINING_SET_DIFFICULTY) {
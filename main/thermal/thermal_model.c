@@ -0,0 +1,175 @@
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "thermal_model.h"
+
+#define CANDIDATES 16                // time constants tried, 10 s * 1.3^i up to ~500 s
+#define SHORTEST_CANDIDATE 10.0f     // s
+#define CANDIDATE_RATIO 1.3f
+#define FORGETTING 0.999f            // per sample, the fit looks back ~30 minutes
+#define MIN_EXCITATION 0.02f         // relative load or fan change since the last identification to count as a step
+#define MIN_EXCITED_SAMPLES 20       // before the identified time constant is used
+#define MIN_FIT_GAIN 0.8f            // the best candidate must leave this share of the worst one's residual or less
+#define FEED_FORWARD_MAX 30.0f       // % fan
+
+static const char * TAG = "thermal_model";
+
+// For each candidate time constant the load and fan are low-passed with it and
+// the temperature is fitted to T = k_u * u' + k_f * F' + c by least squares with
+// forgetting. The candidate whose filtered inputs explain the temperature best
+// is the board's time constant. Only the inputs are filtered, so the sensor
+// noise does not bias the fit.
+typedef struct
+{
+    float time_constant;
+    float load;  // low-passed load, relative to reference_load
+    float fan;   // low-passed fan speed, 0..1
+    float xx[3][3];
+    float xy[3];
+    float yy;
+} candidate;
+
+static candidate candidates[CANDIDATES];
+static float reference_load;
+static float reference_temperature; // the fit runs on the temperature relative to it, keeping the sums small for float
+static float last_load, last_fan;
+static int excited_samples;
+
+static float time_constant = THERMAL_MODEL_DEFAULT_TIME_CONSTANT;
+
+// Load low-passed with the time constant, the temperature follows a load change the same way
+static float slow_load;
+static float feed_forward;
+
+void ThermalModel_reset(void)
+{
+    memset(candidates, 0, sizeof(candidates));
+    float candidate_time_constant = SHORTEST_CANDIDATE;
+    for (int i = 0; i < CANDIDATES; i++) {
+        candidates[i].time_constant = candidate_time_constant;
+        candidate_time_constant *= CANDIDATE_RATIO;
+    }
+    reference_load = 0;
+    reference_temperature = 0;
+    last_load = last_fan = 0;
+    excited_samples = 0;
+    time_constant = THERMAL_MODEL_DEFAULT_TIME_CONSTANT;
+    slow_load = 0;
+    feed_forward = 0;
+}
+
+// Residual sum of squares of the least squares fit, solved by Cramer's rule
+static float residual(const candidate * c)
+{
+    float a[3][3];
+    memcpy(a, c->xx, sizeof(a));
+    for (int i = 0; i < 3; i++) {
+        a[i][i] += 1e-4f; // keeps the system solvable while an input stays constant
+    }
+
+    float det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    if (fabsf(det) < 1e-12f) {
+        return INFINITY;
+    }
+
+    float fit = 0;
+    for (int k = 0; k < 3; k++) {
+        float m[3][3];
+        memcpy(m, a, sizeof(m));
+        for (int i = 0; i < 3; i++) {
+            m[i][k] = c->xy[i];
+        }
+        float det_k = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                      m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        fit += det_k / det * c->xy[k];
+    }
+    return c->yy - fit;
+}
+
+static void identify(float temperature, float load, float fan_perc, float dt_s)
+{
+    if (reference_load <= 0) {
+        reference_load = load;
+        reference_temperature = temperature;
+    }
+    float u = load / reference_load;
+    float y = temperature - reference_temperature;
+    float f = fan_perc / 100.0f;
+
+    if (last_load > 0 && (fabsf(load - last_load) / last_load >= MIN_EXCITATION || fabsf(fan_perc - last_fan) / 100.0f >= MIN_EXCITATION)) {
+        excited_samples++;
+    }
+    last_load = load;
+    last_fan = fan_perc;
+
+    float best = INFINITY, worst = 0;
+    float best_time_constant = time_constant;
+    for (int i = 0; i < CANDIDATES; i++) {
+        candidate * c = &candidates[i];
+        if (c->load == 0) {
+            c->load = u;
+            c->fan = f;
+        }
+        float alpha = 1.0f - expf(-dt_s / c->time_constant);
+        c->load += (u - c->load) * alpha;
+        c->fan += (f - c->fan) * alpha;
+
+        float x[3] = {c->load, c->fan, 1.0f};
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 3; k++) {
+                c->xx[j][k] = c->xx[j][k] * FORGETTING + x[j] * x[k];
+            }
+            c->xy[j] = c->xy[j] * FORGETTING + x[j] * y;
+        }
+        c->yy = c->yy * FORGETTING + y * y;
+
+        float r = residual(c);
+        if (r < best) {
+            best = r;
+            best_time_constant = c->time_constant;
+        }
+        if (r > worst) {
+            worst = r;
+        }
+    }
+
+    // Without load or fan steps every candidate fits about equally
+    if (excited_samples < MIN_EXCITED_SAMPLES || !(best < worst * MIN_FIT_GAIN)) {
+        return;
+    }
+    if (fabsf(best_time_constant - time_constant) > 0.1f * time_constant) {
+        ESP_LOGI(TAG, "Thermal time constant %.0f s", best_time_constant);
+    }
+    time_constant = best_time_constant;
+}
+
+float ThermalModel_update(float temperature, float load, float fan_perc, float dt_s)
+{
+    if (candidates[0].time_constant == 0) {
+        ThermalModel_reset();
+    }
+
+    if (load <= 0 || dt_s <= 0) {
+        return 0;
+    }
+
+    // The fan that actually ran includes the last feed-forward
+    identify(temperature, load, fminf(fmaxf(fan_perc + feed_forward, 0), 100), dt_s);
+
+    if (slow_load <= 0) {
+        slow_load = load;
+    }
+    slow_load += (load - slow_load) * (1.0f - expf(-dt_s / time_constant));
+
+    // At a given temperature the fan has to carry off heat in proportion to the
+    // load, so a relative load step asks for the same relative fan step until
+    // the temperature, and with it the PID, has caught up
+    feed_forward = fminf(fmaxf(fan_perc * (load - slow_load) / slow_load, -FEED_FORWARD_MAX), FEED_FORWARD_MAX);
+    return feed_forward;
+}
+
+float ThermalModel_time_constant(void)
+{
+    return time_constant;
+}
@@ -0,0 +1,19 @@
+#ifndef THERMAL_MODEL_H_
+#define THERMAL_MODEL_H_
+
+#define THERMAL_MODEL_DEFAULT_TIME_CONSTANT 60.0f // s, until the board's own is identified
+
+// Forgets the identified model, e.g. after the ASIC was reinitialized
+void ThermalModel_reset(void);
+
+// Feeds one sample of the fan loop: ASIC temperature, load (input power in W, or the
+// frequency on boards without a power sensor) and fan speed, taken dt_s apart.
+// Identifies the board's thermal time constant from how the temperature follows
+// load and fan changes, and returns the fan percentage to add to the PID output so
+// the fan moves with a load change instead of waiting for the temperature.
+float ThermalModel_update(float temperature, float load, float fan_perc, float dt_s);
+
+// Thermal time constant in s
+float ThermalModel_time_constant(void);
+
+#endif /* THERMAL_MODEL_H_ */